@@ -0,0 +1,329 @@
+// Сквозной замер пропускной способности и задержки терминала через псевдотерминал.
+//
+// Создаётся пара pty (openpty): MainWindow открывает подчинённую сторону как обычный последовательный порт,
+// поток-имитатор пишет в ведущую (приём) или читает из неё (передача, --tx) с заданной скоростью и размером пакета.
+// Задержка - от записи пакета в pty до передачи его последнего байта панелям приёма (сигнал incomingPresented),
+// для передачи - от вызова MainWindow::send до чтения последнего байта с ведущей стороны.
+//
+// Запуск без дисплея: по умолчанию используется QT_QPA_PLATFORM=offscreen.
+//   uart_benchmark --rate 1000000 --packet 64 --duration 10 [--threaded] [--tx]
+
+#include "mainwindow.h"
+#include "monotonicclock.h"
+#include "spscringbuffer.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace
+{
+struct Options
+{
+    quint64 rate = 0;           // байт/с, 0 - без ограничения
+    int packet = 64;
+    int duration = 10;          // с
+    qint32 baudRate = 115200;
+    bool threaded = false;
+    bool tx = false;
+};
+
+// Конец пакета в общем потоке и время его отправки
+struct SentPacket
+{
+    quint64 end;
+    qint64 timestamp;
+};
+
+const size_t SENT_RING_SIZE = 1024 * 1024;
+// Сколько ждать оставшиеся данные после окончания отправки
+const qint64 DRAIN_TIMEOUT_NS = 2000000000LL;
+
+qint64 cpuTimeNs(int who)
+{
+    rusage usage;
+    getrusage(who, &usage);
+    return (static_cast<qint64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000LL
+            + (static_cast<qint64>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000LL;
+}
+
+QByteArray makePacket(int size)
+{
+    // Печатные строки, чтобы панель ASCII работала как с обычным текстовым потоком
+    QByteArray packet(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        packet[i] = static_cast<char>('a' + i % 26);
+    packet[size - 1] = '\n';
+    return packet;
+}
+
+bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Отметка о пакете для замера задержки; если буфер отметок полон, пакет просто не участвует в замере
+void recordPacket(SpscRingBuffer<SentPacket> &ring, quint64 end)
+{
+    const SentPacket packet = {end, MonotonicClock::nowNs()};
+    ring.write(&packet, 1);
+}
+
+// Все пакеты, полностью дошедшие до received, получают задержку now - время отправки
+void collectLatencies(SpscRingBuffer<SentPacket> &ring, quint64 received, std::vector<qint64> &latencies)
+{
+    const qint64 now = MonotonicClock::nowNs();
+    size_t length;
+    const SentPacket *packet = ring.readSpan(length);
+    while (length > 0 && packet->end <= received)
+    {
+        latencies.push_back(now - packet->timestamp);
+        ring.commitRead(1);
+        packet = ring.readSpan(length);
+    }
+}
+
+void printReport(const Options &options, quint64 sent, quint64 received, quint64 dropped, qint64 elapsedNs,
+                 std::vector<qint64> &latencies, qint64 terminalCpuNs, qint64 driverCpuNs)
+{
+    const double seconds = elapsedNs / 1e9;
+    std::printf("direction:      %s (%s)\n", options.tx ? "tx" : "rx", options.threaded ? "threaded reader" : "GUI thread");
+    std::printf("packet:         %d bytes, target rate %s\n", options.packet,
+                options.rate ? qPrintable(QString::number(options.rate) + " B/s") : "unlimited");
+    std::printf("sent:           %llu bytes\n", static_cast<unsigned long long>(sent));
+    std::printf("received:       %llu bytes\n", static_cast<unsigned long long>(received));
+    std::printf("lost:           %llu bytes (reader dropped %llu)\n",
+                static_cast<unsigned long long>(sent > received ? sent - received : 0),
+                static_cast<unsigned long long>(dropped));
+    std::printf("throughput:     %.0f B/s over %.2f s\n", received / seconds, seconds);
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&](double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))] / 1e6;
+        };
+        std::printf("latency, ms:    p50 %.3f  p90 %.3f  p99 %.3f  max %.3f (%zu packets)\n",
+                    percentile(0.5), percentile(0.9), percentile(0.99), latencies.back() / 1e6, latencies.size());
+    }
+
+    std::printf("cpu:            terminal %.1f%%, driver %.1f%%\n",
+                100.0 * terminalCpuNs / elapsedNs, 100.0 * driverCpuNs / elapsedNs);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("UART terminal throughput and latency benchmark over a pseudo-terminal"));
+    parser.addHelpOption();
+    parser.addOptions({
+        {QStringLiteral("rate"), QStringLiteral("Target rate, bytes/s (0 = unlimited)."), QStringLiteral("bytes"), QStringLiteral("0")},
+        {QStringLiteral("packet"), QStringLiteral("Packet size, bytes."), QStringLiteral("bytes"), QStringLiteral("64")},
+        {QStringLiteral("duration"), QStringLiteral("Send duration, seconds."), QStringLiteral("seconds"), QStringLiteral("10")},
+        {QStringLiteral("baud"), QStringLiteral("Baud rate set on the port."), QStringLiteral("baud"), QStringLiteral("115200")},
+        {QStringLiteral("threaded"), QStringLiteral("Read the port in the dedicated reader thread.")},
+        {QStringLiteral("tx"), QStringLiteral("Measure the send path instead of the receive path.")}
+    });
+    parser.process(app);
+
+    Options options;
+    options.rate = parser.value(QStringLiteral("rate")).toULongLong();
+    options.packet = qMax(1, parser.value(QStringLiteral("packet")).toInt());
+    options.duration = qMax(1, parser.value(QStringLiteral("duration")).toInt());
+    options.baudRate = parser.value(QStringLiteral("baud")).toInt();
+    options.threaded = parser.isSet(QStringLiteral("threaded"));
+    options.tx = parser.isSet(QStringLiteral("tx"));
+
+    int master, slave;
+    char slaveName[256];
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) != 0)
+    {
+        std::perror("openpty");
+        return 1;
+    }
+
+    MainWindow window;
+    window.show();
+
+    SettingsDialog::Settings settings;
+    settings.name = QString::fromLocal8Bit(slaveName);
+    settings.baudRate = options.baudRate;
+    settings.dataBits = QSerialPort::Data8;
+    settings.parity = QSerialPort::NoParity;
+    settings.stopBits = QSerialPort::OneStop;
+    settings.flowControl = QSerialPort::NoFlowControl;
+    settings.localEchoEnabled = false;
+
+    QString error;
+    if (!window.openPort(settings, options.threaded, error))
+    {
+        std::fprintf(stderr, "cannot open %s: %s\n", slaveName, qPrintable(error));
+        return 1;
+    }
+    // Порт настроил подчинённую сторону (raw), наш дескриптор больше не нужен
+    ::close(slave);
+
+    const QByteArray packet = makePacket(options.packet);
+    const qint64 durationNs = options.duration * 1000000000LL;
+
+    SpscRingBuffer<SentPacket> sentPackets(SENT_RING_SIZE);
+    std::vector<qint64> latencies;
+    std::atomic<quint64> sent{0};
+    std::atomic<quint64> received{0};
+    std::atomic<bool> sending{true};
+    std::atomic<bool> stop{false};
+    std::atomic<qint64> driverCpuNs{0};
+
+    const qint64 start = MonotonicClock::nowNs();
+    const qint64 startCpu = cpuTimeNs(RUSAGE_SELF);
+    std::thread driver;
+
+    if (!options.tx)
+    {
+        // Приём: имитатор пишет в ведущую сторону pty
+        driver = std::thread([&]() {
+            quint64 total = 0;
+            while (!stop && MonotonicClock::nowNs() - start < durationNs)
+            {
+                if (options.rate > 0)
+                {
+                    const qint64 due = start + static_cast<qint64>(total * 1000000000ULL / options.rate);
+                    const qint64 wait = due - MonotonicClock::nowNs();
+                    if (wait > 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::nanoseconds(qMin<qint64>(wait, 1000000)));
+                        continue;
+                    }
+                }
+
+                if (!writeAll(master, packet.constData(), static_cast<size_t>(packet.size())))
+                    break;
+                total += static_cast<quint64>(packet.size());
+                sent.store(total, std::memory_order_relaxed);
+                recordPacket(sentPackets, total);
+            }
+            driverCpuNs = cpuTimeNs(RUSAGE_THREAD);
+            sending = false;
+        });
+
+        QObject::connect(&window, &MainWindow::incomingPresented, &window, [&](quint64 bytes) {
+            received.store(bytes, std::memory_order_relaxed);
+            collectLatencies(sentPackets, bytes, latencies);
+        });
+    }
+    else
+    {
+        // Передача: GUI отправляет пакеты по таймеру, имитатор читает ведущую сторону
+        driver = std::thread([&]() {
+            std::vector<char> buffer(64 * 1024);
+            pollfd fd = {master, POLLIN, 0};
+            quint64 total = 0;
+            while (!stop)
+            {
+                if (poll(&fd, 1, 50) <= 0)
+                    continue;
+                const ssize_t n = ::read(master, buffer.data(), buffer.size());
+                if (n <= 0)
+                    break;
+                total += static_cast<quint64>(n);
+                received.store(total, std::memory_order_relaxed);
+                collectLatencies(sentPackets, total, latencies);
+            }
+            driverCpuNs = cpuTimeNs(RUSAGE_THREAD);
+        });
+
+        QTimer *sender = new QTimer(&window);
+        sender->setTimerType(Qt::PreciseTimer);
+        QObject::connect(sender, &QTimer::timeout, &window, [&, sender]() {
+            const qint64 now = MonotonicClock::nowNs();
+            if (now - start >= durationNs)
+            {
+                sender->stop();
+                sending = false;
+                return;
+            }
+
+            // За один тик отправляется всё, что положено по скорости, без ограничения - один пакет
+            quint64 total = sent.load(std::memory_order_relaxed);
+            const quint64 due = options.rate > 0 ? static_cast<quint64>((now - start) / 1e9 * options.rate)
+                                                 : total + static_cast<quint64>(packet.size());
+            while (total < due)
+            {
+                window.send(packet);
+                total += static_cast<quint64>(packet.size());
+                recordPacket(sentPackets, total);
+            }
+            sent.store(total, std::memory_order_relaxed);
+        });
+        sender->start(options.rate > 0 ? 1 : 0);
+    }
+
+    // Завершение: отправка закончена и всё дошло, либо данные перестали поступать
+    quint64 lastReceived = 0;
+    qint64 lastProgress = MonotonicClock::nowNs();
+    quint64 dropped = 0;
+    qint64 elapsedNs = 0;
+    qint64 terminalCpuNs = 0;
+    QTimer monitor;
+    QObject::connect(&monitor, &QTimer::timeout, &window, [&]() {
+        const qint64 now = MonotonicClock::nowNs();
+        const quint64 bytes = received.load(std::memory_order_relaxed);
+        if (bytes != lastReceived)
+        {
+            lastReceived = bytes;
+            lastProgress = now;
+        }
+
+        if (sending || (bytes < sent.load(std::memory_order_relaxed) && now - lastProgress < DRAIN_TIMEOUT_NS))
+            return;
+
+        monitor.stop();
+        elapsedNs = lastProgress - start;
+        dropped = window.droppedBytes();
+        terminalCpuNs = cpuTimeNs(RUSAGE_SELF) - startCpu;
+        app.quit();
+    });
+    monitor.start(100);
+
+    app.exec();
+
+    stop = true;
+    driver.join();
+    window.closePort();
+    ::close(master);
+
+    printReport(options, sent, received, dropped, qMax<qint64>(elapsedNs, 1), latencies,
+                terminalCpuNs - driverCpuNs, driverCpuNs);
+    return 0;
+}
@@ -0,0 +1,86 @@
+# Сквозной замер терминала через псевдотерминал (только Linux/unix).
+# Сборка отдельно от приложения: qmake benchmark/benchmark.pro && make
+
+QT       += core gui serialport widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = uart_benchmark
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    benchmark.cpp \
+    ../bytesearch.cpp \
+    ../bytestore.cpp \
+    ../byteview.cpp \
+    ../capturefile.cpp \
+    ../df_player.cpp \
+    ../dfplayercatalog.cpp \
+    ../dfplayercommandqueue.cpp \
+    ../dfplayercommands.cpp \
+    ../dfplayerdecoder.cpp \
+    ../dfplayerdevice.cpp \
+    ../dfplayerengine.cpp \
+    ../dfplayerfleet.cpp \
+    ../dfplayerfleetpanel.cpp \
+    ../dfplayerframeparser.cpp \
+    ../dfplayerplaylist.cpp \
+    ../dfplayerqueries.cpp \
+    ../dfplayersoaktest.cpp \
+    ../dfplayerstate.cpp \
+    ../framesplitter.cpp \
+    ../hexcodec.cpp \
+    ../mainwindow.cpp \
+    ../monotonicclock.cpp \
+    ../portdispatcher.cpp \
+    ../presentationscheduler.cpp \
+    ../protocoldecoder.cpp \
+    ../protocollog.cpp \
+    ../serialiopool.cpp \
+    ../serialreader.cpp \
+    ../settingsdialog.cpp
+
+HEADERS += \
+    ../bytesearch.h \
+    ../bytestore.h \
+    ../byteview.h \
+    ../capturefile.h \
+    ../df_player.h \
+    ../dfplayercatalog.h \
+    ../dfplayercommandqueue.h \
+    ../dfplayercommands.h \
+    ../dfplayerdecoder.h \
+    ../dfplayerdevice.h \
+    ../dfplayerengine.h \
+    ../dfplayerfleet.h \
+    ../dfplayerfleetpanel.h \
+    ../dfplayerframeparser.h \
+    ../dfplayerplaylist.h \
+    ../dfplayerqueries.h \
+    ../dfplayersoaktest.h \
+    ../dfplayerstate.h \
+    ../framesplitter.h \
+    ../hexcodec.h \
+    ../mainwindow.h \
+    ../monotonicclock.h \
+    ../portdispatcher.h \
+    ../presentationscheduler.h \
+    ../protocoldecoder.h \
+    ../protocollog.h \
+    ../serialiopool.h \
+    ../serialreader.h \
+    ../settingsdialog.h \
+    ../spscringbuffer.h
+
+FORMS += \
+    ../df_player.ui \
+    ../dfplayerfleetpanel.ui \
+    ../mainwindow.ui \
+    ../settingsdialog.ui
+
+RESOURCES += \
+    ../terminal.qrc
+
+LIBS += -lutil
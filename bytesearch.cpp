@@ -0,0 +1,155 @@
+#include "bytesearch.h"
+#include "hexcodec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+QByteArray ByteSearch::parsePattern(const QString &text, Mode mode)
+{
+    if (mode == Text)
+        return text.toUtf8();
+
+    if (mode == Hex)
+        return HexCodec::fromHex(text);
+
+    const QByteArray source = text.toUtf8();
+    QByteArray result;
+    result.reserve(source.size());
+    for (int i = 0; i < source.size(); ++i)
+    {
+        const char ch = source[i];
+        if (ch != '\\' || i + 1 >= source.size())
+        {
+            result += ch;
+            continue;
+        }
+
+        const char code = source[++i];
+        switch (code)
+        {
+        case 'n':
+            result += '\n';
+            break;
+        case 'r':
+            result += '\r';
+            break;
+        case 't':
+            result += '\t';
+            break;
+        case '0':
+            result += '\0';
+            break;
+        case 'x':
+        {
+            // \xH или \xHH
+            int digits = 0;
+            while (digits < 2 && i + 1 + digits < source.size() && std::isxdigit(static_cast<uchar>(source[i + 1 + digits])))
+                ++digits;
+            if (digits == 0)
+            {
+                result += "\\x";
+                break;
+            }
+            result += static_cast<char>(source.mid(i + 1, digits).toInt(nullptr, 16));
+            i += digits;
+            break;
+        }
+        default:
+            result += code;
+        }
+    }
+    return result;
+}
+
+void ByteSearch::setStore(const ByteStore *store)
+{
+    _store = store;
+    reset();
+}
+
+void ByteSearch::setPattern(const QByteArray &pattern)
+{
+    _pattern = pattern;
+    reset();
+}
+
+const QByteArray &ByteSearch::pattern() const
+{
+    return _pattern;
+}
+
+void ByteSearch::update()
+{
+    const size_t length = static_cast<size_t>(_pattern.size());
+    if (!_store || length == 0 || _store->size() < length)
+        return;
+
+    const quint64 last = _store->size() - length;
+    const char first = _pattern[0];
+
+    quint64 pos = _nextStart;
+    while (pos <= last)
+    {
+        size_t available;
+        const char *data = _store->span(pos, available);
+        available = static_cast<size_t>(qMin<quint64>(available, last - pos + 1));
+
+        const char *found = static_cast<const char *>(std::memchr(data, first, available));
+        if (!found)
+        {
+            pos += available;
+            continue;
+        }
+
+        pos += static_cast<quint64>(found - data);
+        if (matchesAt(pos))
+            _hits.push_back(pos);
+        ++pos;
+    }
+
+    _nextStart = pos;
+}
+
+void ByteSearch::reset()
+{
+    _hits.clear();
+    _hits.shrink_to_fit();
+    _nextStart = 0;
+}
+
+const std::vector<quint64> &ByteSearch::hits() const
+{
+    return _hits;
+}
+
+qint64 ByteSearch::nextHit(quint64 offset) const
+{
+    const auto it = std::upper_bound(_hits.begin(), _hits.end(), offset);
+    return it == _hits.end() ? -1 : static_cast<qint64>(it - _hits.begin());
+}
+
+qint64 ByteSearch::previousHit(quint64 offset) const
+{
+    const auto it = std::lower_bound(_hits.begin(), _hits.end(), offset);
+    return it == _hits.begin() ? -1 : static_cast<qint64>(it - _hits.begin()) - 1;
+}
+
+bool ByteSearch::matchesAt(quint64 offset) const
+{
+    // Совпадение может пересекать границу блоков хранилища
+    const char *pattern = _pattern.constData();
+    size_t left = static_cast<size_t>(_pattern.size());
+    while (left > 0)
+    {
+        size_t available;
+        const char *data = _store->span(offset, available);
+        const size_t n = qMin(available, left);
+        if (n == 0 || std::memcmp(data, pattern, n) != 0)
+            return false;
+        pattern += n;
+        offset += n;
+        left -= n;
+    }
+    return true;
+}
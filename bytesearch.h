@@ -0,0 +1,52 @@
+#ifndef BYTESEARCH_H
+#define BYTESEARCH_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+#include "bytestore.h"
+
+// Поиск последовательности байт в ByteStore. Кандидаты ищутся memchr по первому байту образца,
+// при поступлении новых данных просматриваются только они (с учётом совпадения на стыке).
+class ByteSearch
+{
+public:
+    enum Mode
+    {
+        Text,       // строка в UTF-8
+        Hex,        // байты в шестнадцатеричном виде: "7E FF 06" или "7EFF06"
+        Escaped     // строка с \n \r \t \0 \\ \xHH
+    };
+
+    static QByteArray parsePattern(const QString &text, Mode mode);
+
+    void setStore(const ByteStore *store);
+    // Новый образец: совпадения ищутся заново по всей истории
+    void setPattern(const QByteArray &pattern);
+    const QByteArray &pattern() const;
+
+    // Досмотреть данные, добавленные в хранилище с прошлого вызова
+    void update();
+    // Хранилище очищено
+    void reset();
+
+    // Смещения совпадений по возрастанию
+    const std::vector<quint64> &hits() const;
+
+    // Номер первого совпадения после offset / последнего перед offset, -1 если нет
+    qint64 nextHit(quint64 offset) const;
+    qint64 previousHit(quint64 offset) const;
+
+private:
+    bool matchesAt(quint64 offset) const;
+
+    const ByteStore *_store = nullptr;
+    QByteArray _pattern;
+    std::vector<quint64> _hits;
+    // Первая ещё не проверенная позиция начала совпадения
+    quint64 _nextStart = 0;
+};
+
+#endif // BYTESEARCH_H
@@ -0,0 +1,102 @@
+#include "bytestore.h"
+#include "monotonicclock.h"
+
+#include <cstring>
+
+ByteStore::ByteStore()
+    : _anchorNs(MonotonicClock::anchorNs()),
+      _anchorWallClockMs(MonotonicClock::anchorWallClockMs())
+{
+}
+
+void ByteStore::append(const char *data, size_t size, qint64 timestamp)
+{
+    if (size == 0)
+        return;
+
+    Record record;
+    record.offset = _size;
+    record.length = static_cast<quint32>(size);
+    record.timestamp = timestamp;
+    _records.push_back(record);
+
+    while (size > 0)
+    {
+        const size_t inBlock = static_cast<size_t>(_size % BLOCK_SIZE);
+        if (inBlock == 0 && _blocks.size() * BLOCK_SIZE <= _size)
+            _blocks.emplace_back(new char[BLOCK_SIZE]);
+
+        const size_t n = qMin(size, BLOCK_SIZE - inBlock);
+        std::memcpy(_blocks.back().get() + inBlock, data, n);
+        data += n;
+        size -= n;
+        _size += n;
+    }
+}
+
+void ByteStore::clear()
+{
+    _blocks.clear();
+    _records.clear();
+    _records.shrink_to_fit();
+    _size = 0;
+
+    setClockAnchor(MonotonicClock::anchorNs(), MonotonicClock::anchorWallClockMs());
+}
+
+void ByteStore::setClockAnchor(qint64 monotonicNs, qint64 wallClockMs)
+{
+    _anchorNs = monotonicNs;
+    _anchorWallClockMs = wallClockMs;
+}
+
+qint64 ByteStore::wallClockNs(qint64 timestamp) const
+{
+    return _anchorWallClockMs * MonotonicClock::NS_PER_MS + (timestamp - _anchorNs);
+}
+
+quint64 ByteStore::size() const
+{
+    return _size;
+}
+
+const std::vector<ByteStore::Record> &ByteStore::records() const
+{
+    return _records;
+}
+
+const char *ByteStore::span(quint64 offset, size_t &length) const
+{
+    if (offset >= _size)
+    {
+        length = 0;
+        return nullptr;
+    }
+
+    const size_t block = static_cast<size_t>(offset / BLOCK_SIZE);
+    const size_t inBlock = static_cast<size_t>(offset % BLOCK_SIZE);
+    length = static_cast<size_t>(qMin<quint64>(BLOCK_SIZE - inBlock, _size - offset));
+    return _blocks[block].get() + inBlock;
+}
+
+void ByteStore::copy(quint64 offset, char *dst, size_t length) const
+{
+    while (length > 0)
+    {
+        size_t available;
+        const char *src = span(offset, available);
+        if (!src)
+            return;
+
+        const size_t n = qMin(length, available);
+        std::memcpy(dst, src, n);
+        dst += n;
+        offset += n;
+        length -= n;
+    }
+}
+
+size_t ByteStore::memoryUsage() const
+{
+    return _blocks.size() * BLOCK_SIZE + _records.capacity() * sizeof(Record);
+}
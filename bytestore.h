@@ -0,0 +1,52 @@
+#ifndef BYTESTORE_H
+#define BYTESTORE_H
+
+#include <QtGlobal>
+
+#include <memory>
+#include <vector>
+
+// Хранилище принятых байт: данные только дописываются в блоки фиксированного размера
+// (без перевыделения и копирования), для каждой порции хранится смещение и время приёма.
+// Время - отметка монотонных часов в наносекундах, снятая при чтении порта.
+class ByteStore
+{
+public:
+    struct Record
+    {
+        quint64 offset;
+        quint32 length;
+        qint64 timestamp;
+    };
+
+    static const size_t BLOCK_SIZE = 1024 * 1024;
+
+    ByteStore();
+
+    void append(const char *data, size_t size, qint64 timestamp);
+    void clear();
+
+    // Пара "монотонное время - системное время" для перевода отметок в абсолютное время.
+    // По умолчанию - часы этого процесса, для загруженной записи - из её заголовка.
+    void setClockAnchor(qint64 monotonicNs, qint64 wallClockMs);
+    qint64 wallClockNs(qint64 timestamp) const;
+
+    quint64 size() const;
+    const std::vector<Record> &records() const;
+
+    // Непрерывный участок данных начиная с offset (не дальше конца блока)
+    const char *span(quint64 offset, size_t &length) const;
+    void copy(quint64 offset, char *dst, size_t length) const;
+
+    size_t memoryUsage() const;
+
+private:
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    std::vector<Record> _records;
+    quint64 _size = 0;
+
+    qint64 _anchorNs;
+    qint64 _anchorWallClockMs;
+};
+
+#endif // BYTESTORE_H
@@ -0,0 +1,484 @@
+#include "byteview.h"
+#include "hexcodec.h"
+#include "monotonicclock.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QDateTime>
+#include <QFontDatabase>
+#include <QMenu>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+// "hh:mm:ss.zzzuuu -> "
+static const int TIME_LENGTH = 15;
+static const int MARKER_LENGTH = TIME_LENGTH + 4;
+static const int MARGIN = 4;
+// Копирование в буфер обмена ограничено, чтобы случайное "выделить всё" не подвесило программу
+static const quint64 MAX_COPY_ROWS = 100000;
+static const QColor HIGHLIGHT_COLOR(255, 210, 0);
+static const QColor ANNOTATION_COLOR(0, 110, 180);
+
+ByteView::ByteView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    verticalScrollBar()->setSingleStep(1);
+}
+
+void ByteView::setStore(const ByteStore *store)
+{
+    _store = store;
+    reset();
+}
+
+void ByteView::setSegments(const std::vector<ByteStore::Record> *segments)
+{
+    _segments = segments;
+    reset();
+}
+
+void ByteView::setDecoder(const ProtocolDecoder *decoder)
+{
+    _decoder = decoder;
+    viewport()->update();
+}
+
+void ByteView::setMode(Mode mode)
+{
+    _mode = mode;
+    reset();
+}
+
+void ByteView::setTimeFormat(TimeFormat format)
+{
+    _timeFormat = format;
+    viewport()->update();
+}
+
+void ByteView::setByteDuration(qint64 nanoseconds)
+{
+    _byteDurationNs = qMax<qint64>(0, nanoseconds);
+    viewport()->update();
+}
+
+void ByteView::updateContents()
+{
+    if (!_store)
+        return;
+
+    QScrollBar *bar = verticalScrollBar();
+    const bool atBottom = bar->value() == bar->maximum();
+
+    const std::vector<ByteStore::Record> &records = segments();
+    for (size_t i = _rowStart.size(); i < records.size(); ++i)
+    {
+        _rowStart.push_back(_rows);
+        _rows += countRows(records[i]);
+    }
+
+    updateScrollBars();
+    if (atBottom)
+        bar->setValue(bar->maximum());
+
+    viewport()->update();
+}
+
+void ByteView::reset()
+{
+    _rowStart.clear();
+    _rowStart.shrink_to_fit();
+    _rows = 0;
+    _selectionStart = _selectionEnd = -1;
+    _highlightLength = 0;
+    verticalScrollBar()->setValue(0);
+
+    updateContents();
+    viewport()->update();
+}
+
+const std::vector<ByteStore::Record> &ByteView::segments() const
+{
+    return _segments ? *_segments : _store->records();
+}
+
+template <typename Callback>
+void ByteView::splitRows(const ByteStore::Record &record, Callback &&callback) const
+{
+    const quint64 end = record.offset + record.length;
+
+    if (_mode == Hex)
+    {
+        for (quint64 offset = record.offset; offset < end; offset += HEX_BYTES_PER_ROW)
+        {
+            if (!callback(offset, static_cast<size_t>(qMin<quint64>(HEX_BYTES_PER_ROW, end - offset))))
+                return;
+        }
+        return;
+    }
+
+    // ASCII: строка заканчивается переводом строки или по ширине ASCII_COLUMNS
+    quint64 rowStart = record.offset;
+    quint64 pos = record.offset;
+    while (pos < end)
+    {
+        size_t length;
+        const char *data = _store->span(pos, length);
+        const quint64 room = ASCII_COLUMNS - (pos - rowStart);
+        length = static_cast<size_t>(qMin(qMin<quint64>(length, end - pos), room));
+
+        const char *newline = static_cast<const char *>(std::memchr(data, '\n', length));
+        if (newline)
+        {
+            const size_t n = static_cast<size_t>(newline - data);
+            if (!callback(rowStart, static_cast<size_t>(pos + n - rowStart)))
+                return;
+            pos += n + 1;
+            rowStart = pos;
+        }
+        else
+        {
+            pos += length;
+            if (pos - rowStart == ASCII_COLUMNS)
+            {
+                if (!callback(rowStart, static_cast<size_t>(ASCII_COLUMNS)))
+                    return;
+                rowStart = pos;
+            }
+        }
+    }
+
+    if (pos > rowStart || rowStart == record.offset)
+        callback(rowStart, static_cast<size_t>(pos - rowStart));
+}
+
+quint64 ByteView::countRows(const ByteStore::Record &record) const
+{
+    if (_mode == Hex)
+        return qMax<quint64>(1, (record.length + HEX_BYTES_PER_ROW - 1) / HEX_BYTES_PER_ROW);
+
+    quint64 rows = 0;
+    splitRows(record, [&rows](quint64, size_t) {
+        ++rows;
+        return true;
+    });
+    return rows;
+}
+
+template <typename Callback>
+void ByteView::forEachRow(quint64 firstRow, quint64 count, Callback &&callback) const
+{
+    if (!_store || firstRow >= _rows || count == 0)
+        return;
+
+    const std::vector<ByteStore::Record> &records = segments();
+    size_t index = static_cast<size_t>(std::upper_bound(_rowStart.begin(), _rowStart.end(), firstRow) - _rowStart.begin()) - 1;
+    quint64 skip = firstRow - _rowStart[index];
+    quint64 left = count;
+
+    for (; index < _rowStart.size() && left > 0; ++index, skip = 0)
+    {
+        const ByteStore::Record &record = records[index];
+        quint64 local = 0;
+        splitRows(record, [&](quint64 offset, size_t length) {
+            if (local++ < skip)
+                return true;
+            callback(record, local == 1, offset, length);
+            return --left > 0;
+        });
+    }
+}
+
+quint64 ByteView::rowOfOffset(quint64 offset) const
+{
+    if (!_store || _rowStart.empty())
+        return 0;
+
+    const std::vector<ByteStore::Record> &records = segments();
+    const auto end = records.begin() + static_cast<std::ptrdiff_t>(_rowStart.size());
+    const auto it = std::upper_bound(records.begin(), end, offset,
+                                     [](quint64 value, const ByteStore::Record &record) { return value < record.offset; });
+    const size_t index = it == records.begin() ? 0 : static_cast<size_t>(it - records.begin()) - 1;
+
+    // Последняя строка записи, начинающаяся не позже offset
+    quint64 row = _rowStart[index];
+    quint64 local = 0;
+    splitRows(records[index], [&](quint64 rowOffset, size_t) {
+        if (rowOffset > offset)
+            return false;
+        row = _rowStart[index] + local++;
+        return true;
+    });
+    return row;
+}
+
+void ByteView::setHighlight(quint64 offset, quint64 length)
+{
+    _highlightOffset = offset;
+    _highlightLength = length;
+    viewport()->update();
+}
+
+void ByteView::scrollToOffset(quint64 offset)
+{
+    const quint64 row = rowOfOffset(offset);
+    const quint64 half = static_cast<quint64>(visibleRows() / 2);
+    verticalScrollBar()->setValue(static_cast<int>(qMin<quint64>(INT_MAX, row > half ? row - half : 0)));
+}
+
+static QString formatSeconds(qint64 nanoseconds, QChar sign)
+{
+    if (nanoseconds < 0)
+    {
+        sign = '-';
+        nanoseconds = -nanoseconds;
+    }
+    return QString("%1%2.%3").arg(sign).arg(nanoseconds / 1000000000).arg(nanoseconds / 1000 % 1000000, 6, 10, QChar('0'));
+}
+
+QString ByteView::timeMarker(const ByteStore::Record &record, quint64 rowOffset) const
+{
+    // Отметка снята после приёма последнего байта порции, время первого байта строки оценивается по скорости
+    qint64 timestamp = record.timestamp;
+    if (_byteDurationNs > 0)
+        timestamp -= static_cast<qint64>(record.offset + record.length - 1 - rowOffset) * _byteDurationNs;
+
+    const std::vector<ByteStore::Record> &records = segments();
+    QString text;
+    switch (_timeFormat)
+    {
+    case RelativeTime:
+        text = formatSeconds(timestamp - records.front().timestamp, '+');
+        break;
+    case DeltaTime:
+    {
+        const size_t index = static_cast<size_t>(&record - records.data());
+        text = formatSeconds(index > 0 ? timestamp - records[index - 1].timestamp : 0, QChar(0x0394));
+        break;
+    }
+    default:
+    {
+        const qint64 wallClockNs = _store->wallClockNs(timestamp);
+        text = QDateTime::fromMSecsSinceEpoch(wallClockNs / MonotonicClock::NS_PER_MS).toString("hh:mm:ss.zzz")
+                + QString("%1").arg(wallClockNs / 1000 % 1000, 3, 10, QChar('0'));
+    }
+    }
+
+    return text.leftJustified(TIME_LENGTH, ' ') + " -> ";
+}
+
+QString ByteView::rowText(quint64 offset, size_t length) const
+{
+    QByteArray bytes(static_cast<int>(length), Qt::Uninitialized);
+    _store->copy(offset, bytes.data(), length);
+
+    if (_mode == Hex)
+        return HexCodec::toHex(bytes, ':');
+
+    QString text = QString::fromUtf8(bytes);
+    text.remove('\r');
+    for (QChar &ch : text)
+    {
+        if (ch == '\t')
+            ch = ' ';
+        else if (ch.unicode() < 0x20)
+            ch = '.';
+    }
+    return text;
+}
+
+QString ByteView::annotation(quint64 offset, size_t length) const
+{
+    if (!_decoder)
+        return QString();
+
+    const std::pair<size_t, size_t> range = _decoder->packetsEndingIn(offset, length);
+    QStringList notes;
+    for (size_t i = range.first; i < range.second; ++i)
+        notes << _decoder->describe(_decoder->packets()[i]);
+    return notes.join(QStringLiteral("; "));
+}
+
+int ByteView::lineHeight() const
+{
+    return fontMetrics().lineSpacing();
+}
+
+int ByteView::visibleRows() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+qint64 ByteView::rowAt(int y) const
+{
+    if (_rows == 0)
+        return -1;
+
+    const qint64 row = verticalScrollBar()->value() + qMax(0, y) / lineHeight();
+    return qMin<qint64>(row, static_cast<qint64>(_rows) - 1);
+}
+
+void ByteView::updateScrollBars()
+{
+    const int rows = visibleRows();
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setRange(0, static_cast<int>(qMin<quint64>(INT_MAX, _rows > quint64(rows) ? _rows - rows : 0)));
+
+    const int columns = MARKER_LENGTH + (_mode == Hex ? HEX_BYTES_PER_ROW * 3 : ASCII_COLUMNS);
+    const int width = columns * fontMetrics().horizontalAdvance(QLatin1Char('0')) + 2 * MARGIN;
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, width - viewport()->width()));
+}
+
+void ByteView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().base());
+
+    if (!_store || _rows == 0)
+        return;
+
+    const int height = lineHeight();
+    const int ascent = fontMetrics().ascent();
+    const int x = MARGIN - horizontalScrollBar()->value();
+    const qint64 selectionLow = qMin(_selectionStart, _selectionEnd);
+    const qint64 selectionHigh = qMax(_selectionStart, _selectionEnd);
+    const QString blankMarker(MARKER_LENGTH, ' ');
+    const int charWidth = fontMetrics().horizontalAdvance(QLatin1Char('0'));
+    const quint64 highlightEnd = _highlightOffset + _highlightLength;
+
+    qint64 row = verticalScrollBar()->value();
+    int y = 0;
+    forEachRow(static_cast<quint64>(row), static_cast<quint64>(visibleRows() + 1),
+               [&](const ByteStore::Record &record, bool firstRow, quint64 offset, size_t length) {
+        if (selectionLow >= 0 && row >= selectionLow && row <= selectionHigh)
+        {
+            painter.fillRect(QRect(0, y, viewport()->width(), height), palette().highlight());
+            painter.setPen(palette().highlightedText().color());
+        }
+        else
+            painter.setPen(palette().text().color());
+
+        // Найденный фрагмент: в HEX - точно по байтам, в ASCII - строка целиком
+        if (_highlightLength > 0 && _highlightOffset < offset + qMax<size_t>(length, 1) && offset < highlightEnd)
+        {
+            if (_mode == Hex)
+            {
+                const int from = static_cast<int>(qMax(offset, _highlightOffset) - offset);
+                const int to = static_cast<int>(qMin<quint64>(offset + length, highlightEnd) - offset);
+                painter.fillRect(QRect(x + (MARKER_LENGTH + from * 3) * charWidth, y, ((to - from) * 3 - 1) * charWidth, height),
+                                 HIGHLIGHT_COLOR);
+            }
+            else
+                painter.fillRect(QRect(x + MARKER_LENGTH * charWidth, y, static_cast<int>(qMax<size_t>(length, 1)) * charWidth, height),
+                                 HIGHLIGHT_COLOR);
+        }
+
+        const bool marked = firstRow || _byteDurationNs > 0;
+        const QString text = (marked ? timeMarker(record, offset) : blankMarker) + rowText(offset, length);
+        painter.drawText(x, y + ascent, text);
+
+        // В HEX описания выровнены по колонке за полной строкой
+        const QString note = annotation(offset, length);
+        if (!note.isEmpty())
+        {
+            const int column = _mode == Hex ? MARKER_LENGTH + HEX_BYTES_PER_ROW * 3 : text.size();
+            if (!(selectionLow >= 0 && row >= selectionLow && row <= selectionHigh))
+                painter.setPen(ANNOTATION_COLOR);
+            painter.drawText(x + (column + 1) * charWidth, y + ascent, note);
+        }
+        y += height;
+        ++row;
+    });
+}
+
+void ByteView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void ByteView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        _selectionStart = _selectionEnd = rowAt(event->pos().y());
+        viewport()->update();
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void ByteView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton && _selectionStart >= 0)
+    {
+        // Прокрутка при выходе курсора за границы окна
+        if (event->pos().y() < 0)
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+        else if (event->pos().y() > viewport()->height())
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+
+        _selectionEnd = rowAt(qMin(event->pos().y(), viewport()->height() - 1));
+        viewport()->update();
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void ByteView::keyPressEvent(QKeyEvent *event)
+{
+    if (event == QKeySequence::Copy)
+        copySelection();
+    else if (event == QKeySequence::SelectAll && _rows > 0)
+    {
+        _selectionStart = 0;
+        _selectionEnd = static_cast<qint64>(_rows) - 1;
+        viewport()->update();
+    }
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void ByteView::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+    QAction *copy = menu.addAction(tr("Копировать"), this, &ByteView::copySelection);
+    copy->setEnabled(_selectionStart >= 0);
+    menu.addAction(tr("Выделить всё"), this, [this]() {
+        if (_rows == 0)
+            return;
+        _selectionStart = 0;
+        _selectionEnd = static_cast<qint64>(_rows) - 1;
+        viewport()->update();
+    });
+    menu.exec(event->globalPos());
+}
+
+void ByteView::copySelection() const
+{
+    if (_selectionStart < 0)
+        return;
+
+    const quint64 low = static_cast<quint64>(qMin(_selectionStart, _selectionEnd));
+    const quint64 high = static_cast<quint64>(qMax(_selectionStart, _selectionEnd));
+    const QString blankMarker(MARKER_LENGTH, ' ');
+
+    QString text;
+    forEachRow(low, qMin(high - low + 1, MAX_COPY_ROWS),
+               [&](const ByteStore::Record &record, bool firstRow, quint64 offset, size_t length) {
+        const bool marked = firstRow || _byteDurationNs > 0;
+        text += (marked ? timeMarker(record, offset) : blankMarker) + rowText(offset, length);
+        const QString note = annotation(offset, length);
+        if (!note.isEmpty())
+            text += "  " + note;
+        text += '\n';
+    });
+
+    QApplication::clipboard()->setText(text);
+}
@@ -0,0 +1,106 @@
+#ifndef BYTEVIEW_H
+#define BYTEVIEW_H
+
+#include <QAbstractScrollArea>
+
+#include <vector>
+
+#include "bytestore.h"
+#include "protocoldecoder.h"
+
+// Просмотр содержимого ByteStore. Строки не хранятся: форматируются только те,
+// что видны на экране. Для каждой записи хранится лишь номер её первой строки.
+// Записи - порции, прочитанные из порта, или кадры (setSegments).
+class ByteView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    enum Mode
+    {
+        Ascii,
+        Hex
+    };
+
+    enum TimeFormat
+    {
+        AbsoluteTime,   // системное время
+        RelativeTime,   // от первой записи
+        DeltaTime       // от предыдущей записи
+    };
+
+    explicit ByteView(QWidget *parent = nullptr);
+
+    void setStore(const ByteStore *store);
+    // Список участков хранилища, показываемых отдельными записями (кадры), nullptr - порции приёма.
+    // Список может только дополняться, после его перестроения нужен reset()
+    void setSegments(const std::vector<ByteStore::Record> *segments);
+    // Описания пакетов показываются в конце строки, где пакет закончился; nullptr - без декодера
+    void setDecoder(const ProtocolDecoder *decoder);
+    void setMode(Mode mode);
+    void setTimeFormat(TimeFormat format);
+    // Длительность передачи одного байта для оценки времени каждой строки, 0 - не оценивать
+    void setByteDuration(qint64 nanoseconds);
+
+    // В хранилище добавлены новые записи
+    void updateContents();
+    // Хранилище очищено
+    void reset();
+
+    void copySelection() const;
+
+    // Подсветка найденного фрагмента и переход к нему
+    void setHighlight(quint64 offset, quint64 length);
+    void scrollToOffset(quint64 offset);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void keyPressEvent(QKeyEvent *event) override;
+    virtual void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    static const int HEX_BYTES_PER_ROW = 16;
+    static const int ASCII_COLUMNS = 128;
+
+    const ByteStore *_store = nullptr;
+    const std::vector<ByteStore::Record> *_segments = nullptr;
+    const ProtocolDecoder *_decoder = nullptr;
+    Mode _mode = Ascii;
+    TimeFormat _timeFormat = AbsoluteTime;
+    qint64 _byteDurationNs = 0;
+
+    // Номер первой строки каждой записи
+    std::vector<quint64> _rowStart;
+    quint64 _rows = 0;
+
+    qint64 _selectionStart = -1;
+    qint64 _selectionEnd = -1;
+
+    quint64 _highlightOffset = 0;
+    quint64 _highlightLength = 0;
+
+    const std::vector<ByteStore::Record> &segments() const;
+
+    template <typename Callback>
+    void splitRows(const ByteStore::Record &record, Callback &&callback) const;
+    quint64 countRows(const ByteStore::Record &record) const;
+
+    template <typename Callback>
+    void forEachRow(quint64 firstRow, quint64 count, Callback &&callback) const;
+
+    quint64 rowOfOffset(quint64 offset) const;
+
+    QString timeMarker(const ByteStore::Record &record, quint64 rowOffset) const;
+    QString rowText(quint64 offset, size_t length) const;
+    QString annotation(quint64 offset, size_t length) const;
+
+    int lineHeight() const;
+    int visibleRows() const;
+    qint64 rowAt(int y) const;
+    void updateScrollBars();
+};
+
+#endif // BYTEVIEW_H
@@ -0,0 +1,358 @@
+#include "capturefile.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace CaptureFile;
+
+static const char FILE_MAGIC[8] = {'U', 'A', 'R', 'T', 'C', 'A', 'P', '1'};
+static const char INDEX_MAGIC[8] = {'U', 'A', 'R', 'T', 'I', 'D', 'X', '1'};
+static const quint16 FORMAT_VERSION = 1;
+static const int PORT_NAME_OFFSET = 41;
+static const int PORT_NAME_MAX = HEADER_SIZE - PORT_NAME_OFFSET;
+
+// Новый элемент индекса, если с предыдущего прошло достаточно байт или времени
+static bool needIndexEntry(const std::vector<IndexEntry> &index, quint64 offset, qint64 timestamp)
+{
+    return index.empty()
+            || offset - index.back().offset >= INDEX_STEP_BYTES
+            || timestamp - index.back().timestamp >= INDEX_STEP_NS;
+}
+
+// Время в индексе не убывает, даже если порции RX и TX записаны не строго по порядку
+static void addIndexEntry(std::vector<IndexEntry> &index, quint64 offset, qint64 timestamp)
+{
+    if (!index.empty())
+        timestamp = qMax(timestamp, index.back().timestamp);
+    index.push_back({timestamp, offset});
+}
+
+CaptureWriter::CaptureWriter(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &fileName, const SettingsDialog::Settings &settings, qint64 startMonotonicNs)
+{
+    close();
+
+    _error.clear();
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+
+    uchar header[HEADER_SIZE] = {};
+    std::memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    qToLittleEndian<quint16>(FORMAT_VERSION, header + 8);
+    qToLittleEndian<quint16>(HEADER_SIZE, header + 10);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 16);
+    qToLittleEndian<qint64>(startMonotonicNs, header + 24);
+    qToLittleEndian<qint32>(settings.baudRate, header + 32);
+    header[36] = static_cast<uchar>(settings.dataBits);
+    header[37] = static_cast<uchar>(settings.parity);
+    header[38] = static_cast<uchar>(settings.stopBits);
+    header[39] = static_cast<uchar>(settings.flowControl);
+
+    const QByteArray name = settings.name.toUtf8().left(PORT_NAME_MAX);
+    header[40] = static_cast<uchar>(name.size());
+    std::memcpy(header + PORT_NAME_OFFSET, name.constData(), static_cast<size_t>(name.size()));
+
+    if (!writeRaw(header, HEADER_SIZE))
+    {
+        _file.close();
+        return false;
+    }
+
+    _position = HEADER_SIZE;
+    _index.clear();
+    return true;
+}
+
+void CaptureWriter::write(Direction direction, qint64 timestamp, const char *data, size_t size)
+{
+    if (!_file.isOpen() || size == 0)
+        return;
+
+    if (needIndexEntry(_index, _position, timestamp))
+        addIndexEntry(_index, _position, timestamp);
+
+    uchar header[RECORD_HEADER_SIZE] = {};
+    qToLittleEndian<quint32>(static_cast<quint32>(size), header);
+    header[4] = direction;
+    qToLittleEndian<qint64>(timestamp, header + 8);
+
+    // Дальше писать некуда (диск заполнен, носитель извлечён): записанное до сбоя читается без индекса
+    if (!writeRaw(header, RECORD_HEADER_SIZE) || !writeRaw(data, static_cast<qint64>(size)))
+    {
+        _file.close();
+        _index.clear();
+        emit failed();
+        return;
+    }
+    _position += RECORD_HEADER_SIZE + size;
+}
+
+bool CaptureWriter::close()
+{
+    if (!_file.isOpen())
+        return true;
+
+    const quint64 indexOffset = _position;
+    bool ok = true;
+    for (const IndexEntry &entry : _index)
+    {
+        uchar raw[16];
+        qToLittleEndian<qint64>(entry.timestamp, raw);
+        qToLittleEndian<quint64>(entry.offset, raw + 8);
+        if (!(ok = writeRaw(raw, sizeof(raw))))
+            break;
+    }
+
+    if (ok)
+    {
+        uchar trailer[TRAILER_SIZE];
+        std::memcpy(trailer, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        qToLittleEndian<quint64>(indexOffset, trailer + 8);
+        qToLittleEndian<quint64>(_index.size(), trailer + 16);
+        ok = writeRaw(trailer, TRAILER_SIZE);
+    }
+    if (ok && !_file.flush())
+    {
+        _error = _file.errorString();
+        ok = false;
+    }
+
+    _file.close();
+    _index.clear();
+    return ok;
+}
+
+bool CaptureWriter::isOpen() const
+{
+    return _file.isOpen();
+}
+
+QString CaptureWriter::errorString() const
+{
+    return _error;
+}
+
+bool CaptureWriter::writeRaw(const void *data, qint64 size)
+{
+    if (_file.write(static_cast<const char *>(data), size) == size)
+        return true;
+
+    _error = _file.errorString();
+    return false;
+}
+
+void CaptureWriter::portReceived(const QByteArray &data, qint64 timestamp)
+{
+    write(Rx, timestamp, data.constData(), static_cast<size_t>(data.size()));
+}
+
+void CaptureWriter::portSent(const QByteArray &data, qint64 timestamp)
+{
+    write(Tx, timestamp, data.constData(), static_cast<size_t>(data.size()));
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const QString &fileName)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::ReadOnly))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+
+    _size = static_cast<quint64>(_file.size());
+    if (_size < static_cast<quint64>(HEADER_SIZE))
+    {
+        _error = QObject::tr("Not a capture file");
+        close();
+        return false;
+    }
+
+    _data = _file.map(0, _file.size());
+    if (!_data)
+    {
+        _error = _file.errorString();
+        close();
+        return false;
+    }
+
+    if (!readHeader())
+    {
+        _error = QObject::tr("Not a capture file");
+        close();
+        return false;
+    }
+
+    if (!readIndex())
+        rebuildIndex();
+
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if (_data)
+        _file.unmap(const_cast<uchar *>(_data));
+    _data = nullptr;
+    _file.close();
+    _size = _recordsEnd = 0;
+    _index.clear();
+    _lastTimestamp = 0;
+}
+
+QString CaptureReader::errorString() const
+{
+    return _error;
+}
+
+const Header &CaptureReader::header() const
+{
+    return _header;
+}
+
+quint64 CaptureReader::firstRecord() const
+{
+    return HEADER_SIZE;
+}
+
+qint64 CaptureReader::firstTimestamp() const
+{
+    return _index.empty() ? _header.startMonotonicNs : _index.front().timestamp;
+}
+
+qint64 CaptureReader::lastTimestamp() const
+{
+    return _lastTimestamp;
+}
+
+quint64 CaptureReader::seek(qint64 timestamp) const
+{
+    auto it = std::upper_bound(_index.begin(), _index.end(), timestamp,
+                               [](qint64 value, const IndexEntry &entry) { return value < entry.timestamp; });
+
+    quint64 offset = it == _index.begin() ? firstRecord() : std::prev(it)->offset;
+
+    Record record;
+    quint64 position = offset;
+    while (next(position, record))
+    {
+        if (record.timestamp >= timestamp)
+            return record.offset;
+    }
+    return _recordsEnd;
+}
+
+bool CaptureReader::next(quint64 &offset, Record &record) const
+{
+    if (offset + RECORD_HEADER_SIZE > _recordsEnd)
+        return false;
+
+    const uchar *raw = _data + offset;
+    const quint32 length = qFromLittleEndian<quint32>(raw);
+    if (offset + RECORD_HEADER_SIZE + length > _recordsEnd)
+        return false;
+
+    record.offset = offset;
+    record.length = length;
+    record.direction = static_cast<Direction>(raw[4]);
+    record.timestamp = qFromLittleEndian<qint64>(raw + 8);
+    record.data = reinterpret_cast<const char *>(raw + RECORD_HEADER_SIZE);
+
+    offset += RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+bool CaptureReader::readHeader()
+{
+    if (std::memcmp(_data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+            || qFromLittleEndian<quint16>(_data + 8) != FORMAT_VERSION
+            || qFromLittleEndian<quint16>(_data + 10) != HEADER_SIZE)
+        return false;
+
+    _header.startWallClockMs = qFromLittleEndian<qint64>(_data + 16);
+    _header.startMonotonicNs = qFromLittleEndian<qint64>(_data + 24);
+    _header.baudRate = qFromLittleEndian<qint32>(_data + 32);
+    _header.dataBits = _data[36];
+    _header.parity = _data[37];
+    _header.stopBits = _data[38];
+    _header.flowControl = _data[39];
+    _header.portName = QString::fromUtf8(reinterpret_cast<const char *>(_data + PORT_NAME_OFFSET),
+                                         qMin<int>(_data[40], PORT_NAME_MAX));
+    return true;
+}
+
+bool CaptureReader::readIndex()
+{
+    if (_size < static_cast<quint64>(HEADER_SIZE + TRAILER_SIZE))
+        return false;
+
+    const uchar *trailer = _data + _size - TRAILER_SIZE;
+    if (std::memcmp(trailer, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+        return false;
+
+    const quint64 indexOffset = qFromLittleEndian<quint64>(trailer + 8);
+    const quint64 count = qFromLittleEndian<quint64>(trailer + 16);
+    // Значения из файла: сумма проверяется без переполнения, до выделения памяти под индекс
+    if (indexOffset < static_cast<quint64>(HEADER_SIZE) || indexOffset > _size - TRAILER_SIZE
+            || count > (_size - TRAILER_SIZE - indexOffset) / 16
+            || indexOffset + count * 16 + TRAILER_SIZE != _size)
+        return false;
+
+    _recordsEnd = indexOffset;
+    _index.resize(static_cast<size_t>(count));
+    for (quint64 i = 0; i < count; ++i)
+    {
+        const uchar *raw = _data + indexOffset + i * 16;
+        _index[static_cast<size_t>(i)] = {qFromLittleEndian<qint64>(raw), qFromLittleEndian<quint64>(raw + 8)};
+    }
+
+    // Время последней записи: проход только от последнего элемента индекса
+    Record record;
+    quint64 offset = _index.empty() ? firstRecord() : _index.back().offset;
+    while (next(offset, record))
+        _lastTimestamp = record.timestamp;
+
+    return true;
+}
+
+void CaptureReader::rebuildIndex()
+{
+    // Файл не был закрыт штатно: последняя неполная запись отбрасывается
+    _recordsEnd = _size;
+    _index.clear();
+
+    Record record;
+    quint64 offset = firstRecord();
+    quint64 end = offset;
+    while (next(offset, record))
+    {
+        if (needIndexEntry(_index, record.offset, record.timestamp))
+            addIndexEntry(_index, record.offset, record.timestamp);
+        _lastTimestamp = record.timestamp;
+        end = offset;
+    }
+    _recordsEnd = end;
+}
@@ -0,0 +1,135 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+#include "portdispatcher.h"
+#include "settingsdialog.h"
+
+// Формат файла записи сеанса (все числа little-endian):
+//
+//   заголовок (HEADER_SIZE байт): сигнатура, версия, время начала (UTC, мс),
+//       отметка монотонных часов в момент начала (нс), параметры порта
+//   записи: u32 длина, u8 направление, 3 байта резерв, i64 время (нс, монотонные часы), данные
+//   индекс: пары (i64 время, u64 смещение записи), примерно одна на INDEX_STEP_BYTES или INDEX_STEP_NS
+//   окончание: сигнатура индекса, u64 смещение индекса, u64 количество элементов
+//
+// Индекс пишется при закрытии. Если файл не был закрыт (сбой), индекс строится при открытии проходом по записям.
+namespace CaptureFile
+{
+enum Direction : quint8
+{
+    Rx = 0,
+    Tx = 1
+};
+
+struct Header
+{
+    qint64 startWallClockMs = 0;
+    qint64 startMonotonicNs = 0;
+    QString portName;
+    qint32 baudRate = 0;
+    quint8 dataBits = 0;
+    quint8 parity = 0;
+    quint8 stopBits = 0;
+    quint8 flowControl = 0;
+};
+
+struct Record
+{
+    quint64 offset;
+    Direction direction;
+    qint64 timestamp;
+    const char *data;
+    quint32 length;
+};
+
+struct IndexEntry
+{
+    qint64 timestamp;
+    quint64 offset;
+};
+
+const int HEADER_SIZE = 128;
+const int RECORD_HEADER_SIZE = 16;
+const int TRAILER_SIZE = 24;
+const quint64 INDEX_STEP_BYTES = 1024 * 1024;
+const qint64 INDEX_STEP_NS = 10LL * 1000 * 1000 * 1000;
+}
+
+// Подписчик диспетчера порта: пишет принятое и отправленное, пока файл открыт.
+// Ошибка записи закрывает файл без индекса (его восстановит CaptureReader) и сообщается сигналом failed
+class CaptureWriter : public QObject, public PortSubscriber
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureWriter(QObject *parent = nullptr);
+    ~CaptureWriter();
+
+    bool open(const QString &fileName, const SettingsDialog::Settings &settings, qint64 startMonotonicNs);
+    void write(CaptureFile::Direction direction, qint64 timestamp, const char *data, size_t size);
+    // false - не записались индекс или окончание файла
+    bool close();
+
+    bool isOpen() const;
+    QString errorString() const;
+
+    virtual void portReceived(const QByteArray &data, qint64 timestamp) override;
+    virtual void portSent(const QByteArray &data, qint64 timestamp) override;
+
+signals:
+    // Файл закрыт из-за ошибки записи, текст - errorString()
+    void failed();
+
+private:
+    bool writeRaw(const void *data, qint64 size);
+
+    QFile _file;
+    quint64 _position = 0;
+    std::vector<CaptureFile::IndexEntry> _index;
+    QString _error;
+};
+
+class CaptureReader
+{
+public:
+    ~CaptureReader();
+
+    // Файл отображается в память целиком, данные не читаются
+    bool open(const QString &fileName);
+    void close();
+
+    QString errorString() const;
+    const CaptureFile::Header &header() const;
+
+    quint64 firstRecord() const;
+    qint64 firstTimestamp() const;
+    qint64 lastTimestamp() const;
+
+    // Смещение первой записи со временем >= timestamp: поиск по индексу и короткий проход
+    quint64 seek(qint64 timestamp) const;
+    // Запись по смещению offset; offset сдвигается на следующую. false - записи закончились
+    bool next(quint64 &offset, CaptureFile::Record &record) const;
+
+private:
+    bool readHeader();
+    bool readIndex();
+    void rebuildIndex();
+
+    QFile _file;
+    const uchar *_data = nullptr;
+    quint64 _size = 0;
+    quint64 _recordsEnd = 0;
+    QString _error;
+
+    CaptureFile::Header _header;
+    std::vector<CaptureFile::IndexEntry> _index;
+    qint64 _lastTimestamp = 0;
+};
+
+#endif // CAPTUREFILE_H
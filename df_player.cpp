@@ -1,917 +1,643 @@
 #include "df_player.h"
 #include "ui_df_player.h"
 
-DF_Player::DF_Player(QSerialPort &serial, QDialog *parent) :
-    QDialog(parent),
-    _serial(serial),
-    ui(new Ui::DF_Player),
-    recDataBufferSize(0),
-    num_folders(0)
-{
-    ui->setupUi(this);
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QSignalBlocker>
 
-    connect(ui->stop, &QPushButton::clicked, this, &DF_Player::stop);
-    connect(ui->next, &QPushButton::clicked, this, &DF_Player::playNext);
-    connect(ui->prev, &QPushButton::clicked, this, &DF_Player::playPrevious);
+#include <cstring>
 
-    connect(&_serial, &QSerialPort::readyRead, this, &DF_Player::dataRecive);
+#include "monotonicclock.h"
 
-    updateData();
+DF_Player::DF_Player(PortDispatcher &port, DFPlayerState &state, DFPlayerCatalog &catalog, ProtocolLog &log,
+                     QWidget *parent) :
+    QWidget(parent),
+    _port(port),
+    ui(new Ui::DF_Player),
+    _engine(port, state),
+    _soak(_engine.commands(), _engine.queries()),
+    _playlist(_engine.commands()),
+    _state(state),
+    _catalog(catalog),
+    _log(log)
+{
+    ui->setupUi(this);
+    DFPlayerCommandQueue &commands = _engine.commands();
+
+    commands.setFrameTime(DFPlayerCommandQueue::frameTimeOf(_port.settings()));
+    _playlist.setFrameTime(DFPlayerCommandQueue::frameTimeOf(_port.settings()));
+
+    connect(ui->stop, &QPushButton::clicked, this, [this]() { send(DFPlayerCommands::Stop); });
+    connect(ui->next, &QPushButton::clicked, this, [this]() { send(DFPlayerCommands::Next); });
+    connect(ui->prev, &QPushButton::clicked, this, [this]() { send(DFPlayerCommands::Previous); });
+
+    _port.subscribe(this);
+    connect(&_port, &PortDispatcher::opened, this, &DF_Player::portOpened);
+    connect(&_port, &PortDispatcher::closed, this, &DF_Player::portClosed);
+    connect(&commands, &DFPlayerCommandQueue::frameSent, this, [this](const QByteArray &frame) {
+        _log.add(ProtocolLog::Sent, frame.constData(), frame.size());
+    });
+    connect(&commands, &DFPlayerCommandQueue::frameRetransmitted, this, [this](const QByteArray &frame, int attempt) {
+        _log.add(ProtocolLog::Retransmitted, frame.constData(), frame.size(), static_cast<quint16>(attempt));
+    });
+    connect(&commands, &DFPlayerCommandQueue::frameFailed, this, [this](const QByteArray &frame) {
+        _log.add(ProtocolLog::Dropped, frame.constData(), frame.size());
+    });
+    connect(&_log, &ProtocolLog::linesReady, this, &DF_Player::showLog);
+    connect(&_soak, &DFPlayerSoakTest::progress, this, [this]() { ui->soakStatus->setText(_soak.summary()); });
+    connect(&_soak, &DFPlayerSoakTest::finished, this, [this]() {
+        const QSignalBlocker blocker(ui->soakStart);
+        ui->soakStart->setChecked(false);
+    });
+    connect(&_playlist, &DFPlayerPlaylist::currentChanged, this, [this](int index) {
+        const QSignalBlocker blocker(ui->playlist);
+        ui->playlist->setCurrentRow(index);
+    });
+    connect(&_playlist, &DFPlayerPlaylist::finished, this, [this]() {
+        const QSignalBlocker blocker(ui->playlistStart);
+        ui->playlistStart->setChecked(false);
+    });
+    connect(&_playlist, &DFPlayerPlaylist::gapMeasured, this, &DF_Player::showGaps);
+
+    ui->logLevel->setCurrentIndex(_log.level());
+    connect(&commands, &DFPlayerCommandQueue::statisticsChanged, this, &DF_Player::showLinkStatistics);
+    connect(&_engine, &DFPlayerEngine::commandSent, this, [this](quint8 opcode, quint16 param) {
+        _catalog.commandSent(opcode, param, MonotonicClock::nowNs());
+    });
+    connect(&_engine, &DFPlayerEngine::commandRejected, this,
+            [this](DFPlayerCommands::Command command, quint16 first, quint16 second) {
+        const char *name = DFPlayerCommands::TABLE[command].name;
+        _log.add(ProtocolLog::Rejected, name, static_cast<int>(strlen(name)), first, second);
+    });
+    connect(ui->folder, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int folder) {
+        queryFolder(folder);
+        updateTrackRange();
+    });
+    connect(&_state, &DFPlayerState::changed, this, &DF_Player::showState);
+    // Модуль сообщил о смене носителя или перезапуске - обновляются устаревшие поля, без опроса
+    connect(&_state, &DFPlayerState::deviceInserted, this, &DF_Player::updateData);
+    connect(&_state, &DFPlayerState::deviceRemoved, this, &DF_Player::updateData);
+    connect(&_state, &DFPlayerState::deviceOnline, this, &DF_Player::updateData);
+    connect(&_catalog, &DFPlayerCatalog::changed, this, &DF_Player::showCatalog);
+    connect(ui->catalog, &QTreeWidget::itemExpanded, this, &DF_Player::catalogItemExpanded);
+    connect(ui->catalog, &QTreeWidget::itemActivated, this, &DF_Player::catalogItemActivated);
+
+    // Сначала известное из кэша, затем в фоне запрашивается устаревшее
+    showState();
+    showCatalog();
+    if (_port.isOpen())
+        updateData();
 }
 
 DF_Player::~DF_Player()
 {
-    disconnect(&_serial, &QSerialPort::readyRead, this, &DF_Player::dataRecive);
+    _port.unsubscribe(this);
+
+    _catalog.save();
 
     delete ui;
 }
 
 /**************************************************************************/
 /*!
-     @brief  Play the next song in chronological order.
+     @brief  Queue a command for the MP3 player. The frame comes from the
+             DFPlayerCommands table: fixed frames are precomputed, others
+             are built on the stack after the parameters are validated.
+     @param    command
+               The command from the DFPlayerCommands table.
+     @param    first
+               The first parameter (track, volume, folder...).
+     @param    second
+               The second parameter for two-parameter commands.
+     @return   false if the parameters are out of range.
  */
 /**************************************************************************/
-void DF_Player::playNext()
+bool DF_Player::send(DFPlayerCommands::Command command, quint16 first, quint16 second)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_NEXT;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    return _engine.send(command, first, second);
 }
 
 /**************************************************************************/
 /*!
-     @brief  Play the previous song in chronological order.
+     @brief  Query the MP3 player and get the reply asynchronously.
+     @param    command
+               The query from the DFPlayerCommands table; the reply is
+               expected with the code given in the table.
+     @param    param
+               The query parameter (folder number).
+     @param    callback
+               Called with the reply parameter, or with ok == false on an
+               error reply or timeout.
+     @return   false if the parameter is out of range.
  */
 /**************************************************************************/
-void DF_Player::playPrevious()
+bool DF_Player::query(DFPlayerCommands::Command command, quint16 param, DFPlayerQueries::Callback callback)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_PREV;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    return _engine.query(command, param, std::move(callback));
 }
 
 /**************************************************************************/
 /*!
-     @brief  Play a specific track.
-     @param    trackNum
-               The track number to play.
+     @brief  Change the volume by a step. Steps are sent as one absolute
+             volume command based on the not yet sent value or the cached
+             one, so repeated clicks collapse into a single frame.
+     @param    step
+               The volume change, positive or negative.
  */
 /**************************************************************************/
-void DF_Player::play(uint16_t trackNum)
+void DF_Player::stepVolume(int step)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_PLAY;
-    sendDataBuffer[PARAM_MSB] = (trackNum >> 8);
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
-}
+    int volume = _engine.commands().pendingParameter(CTRL_VOLUME);
+    if (volume < 0)
+        volume = _state.value(DFPlayerState::Volume);
 
-/**************************************************************************/
-/*!
-     @brief  Stop the current playback
- */
-/**************************************************************************/
-void DF_Player::stop()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_STOP;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
-}
+    // Громкость неизвестна - относительная команда и запрос результата
+    if (volume < 0)
+    {
+        send(step > 0 ? DFPlayerCommands::VolumeUp : DFPlayerCommands::VolumeDown);
+        send(DFPlayerCommands::QueryVolume);
+        return;
+    }
 
-void DF_Player::playFromRootFolder(uint16_t trackNum)
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_SPEC_PLAY;
-    sendDataBuffer[PARAM_MSB] = (trackNum >> 8);
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
+    const DFPlayerCommands::Range range = DFPlayerCommands::TABLE[DFPlayerCommands::Volume].first;
+    send(DFPlayerCommands::Volume, static_cast<quint16>(qBound<int>(range.min, volume + step, range.max)));
 }
 
 /**************************************************************************/
 /*!
-     @brief  Play a specific track in the folder named "MP3".
-     @param    trackNum
-               The track number to play.
+     @brief  Parse MP3 player query responses.
  */
 /**************************************************************************/
-void DF_Player::playFromMP3Folder(uint16_t trackNum)
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_SPEC_PLAY_MP3;
-    sendDataBuffer[PARAM_MSB] = (trackNum >> 8);
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
-}
 
-/**************************************************************************/
-/*!
-     @brief  Interrupt the current track with a new track.
-     @param    trackNum
-               The track number to play.
- */
-/**************************************************************************/
-void DF_Player::playAdvertisement(uint16_t trackNum)
+void DF_Player::parseData()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_INSERT_ADVERT;
-    sendDataBuffer[PARAM_MSB] = (trackNum >> 8);
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
+    // Текст пакета формирует журнал в своём потоке
+    _log.add(ProtocolLog::Received, recDataBuffer, BUFFER_SIZE);
+
+    // Ответ передаётся ожидающему запросу (если он есть) после обновления состояния
+    const uint8_t command = recDataBuffer[CMD_VALUE];
+    const uint16_t value = ((uint16_t)recDataBuffer[PARAM_MSB] << 8) | recDataBuffer[PARAM_LSB];
+    // Повтор сообщения об окончании трека не доходит ни до кого: он переключил бы плейлист ещё раз
+    if (!_engine.updateState(command, value))
+        return;
+
+    _catalog.messageReceived(command, MonotonicClock::nowNs());
+    _soak.messageReceived(command, value);
+    // Следующий трек плейлиста уходит отсюда же, не дожидаясь цикла событий
+    _playlist.messageReceived(command, value, _receivedAt);
+    _engine.dispatch(command, value);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Stop the interrupting track.
- */
-/**************************************************************************/
-void DF_Player::stopAdvertisement()
+void DF_Player::showLinkStatistics()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_STOP_ADVERT;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
+    if (!_engine.commands().isReliable())
+    {
+        ui->linkLabel->clear();
+        return;
+    }
+
+    const DFPlayerCommandQueue::Statistics &statistics = _engine.commands().statistics();
+    const double msPerNs = 1e-6;
+    QString rtt = QStringLiteral("-");
+    if (statistics.rttSamples)
+    {
+        rtt = tr("%1 мс (%2..%3)")
+                .arg(statistics.totalRttNs * msPerNs / statistics.rttSamples, 0, 'f', 1)
+                .arg(statistics.minRttNs * msPerNs, 0, 'f', 1)
+                .arg(statistics.maxRttNs * msPerNs, 0, 'f', 1);
+    }
+    ui->linkLabel->setText(tr("подтверждено %1, повторов %2, потеряно %3, RTT %4")
+                           .arg(statistics.acknowledged).arg(statistics.retransmits).arg(statistics.failed).arg(rtt));
 }
 
-/**************************************************************************/
-/*!
-     @brief  Increment the volume by 1 out of 30.
- */
-/**************************************************************************/
-void DF_Player::incVolume()
+void DF_Player::portOpened()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_INC_VOL;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    // После переподключения могли измениться скорость порта и сам модуль
+    _engine.commands().setFrameTime(DFPlayerCommandQueue::frameTimeOf(_port.settings()));
+    _playlist.setFrameTime(DFPlayerCommandQueue::frameTimeOf(_port.settings()));
+    _parser.reset();
+    updateData();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Decrement the volume by 1 out of 30.
- */
-/**************************************************************************/
-void DF_Player::decVolume()
+void DF_Player::portClosed()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_DEC_VOL;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    // Неотправленное и неподтверждённое не уйдёт, ожидающие запросы завершаются неудачей
+    _soak.stop();
+    _playlist.stop();
+    ui->playlistStart->setChecked(false);
+    _engine.clear();
+    _parser.reset();
+    _catalog.save();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Set the volume to a specific value out of 30.
-     @param    volume
-               The volume level (0 - 30).
- */
-/**************************************************************************/
-void DF_Player::volume(uint8_t value)
+void DF_Player::updateData()
 {
-    if (value > 30)
-        return;
+    // Запросы только ставятся в очередь, окно остаётся отзывчивым
+    send(DFPlayerCommands::AudioAmplifier, 0, 0);
 
-    sendDataBuffer[CMD_VALUE] = CTRL_VOLUME;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = value;
-    sendData();
+    // Запрашиваются только устаревшие поля, остальное уже показано из кэша.
+    // Запросы независимы и уходят подряд, не дожидаясь ответов; папки перечисляются по требованию
+    for (int field = 0; field < DFPlayerState::FIELD_COUNT; ++field)
+    {
+        if (!_state.isValid(static_cast<DFPlayerState::Field>(field)))
+            send(DFPlayerState::queryOf(static_cast<DFPlayerState::Field>(field)));
+    }
 }
 
-/**************************************************************************/
-/*!
-     @brief  Set the EQ mode.
-     @param    setting
-               The desired EQ ID.
- */
-/**************************************************************************/
-void DF_Player::EQSelect(uint8_t setting)
+void DF_Player::queryFolder(int folder)
 {
-    if (setting > 5)
+    if (folder < 1 || folder > _catalog.folderCount() || _catalog.folderTracks(folder) >= 0
+            || !_folderQueries.insert(folder).second)
         return;
 
-    sendDataBuffer[CMD_VALUE] = CTRL_EQ;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = setting;
-    sendData();
+    const bool queued = query(DFPlayerCommands::QueryFolderFiles, static_cast<quint16>(folder),
+                              [this, folder](bool ok, quint16 tracks) {
+        _folderQueries.erase(folder);
+        if (ok)
+            _catalog.setFolderTracks(folder, tracks);
+    });
+    if (!queued)
+        _folderQueries.erase(folder);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Loop a specific track.
-     @param    trackNum
-               The track number to play.
- */
-/**************************************************************************/
-void DF_Player::loop(uint16_t trackNum)
+void DF_Player::updateTrackRange()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_PLAYBACK_MODE;
-    sendDataBuffer[PARAM_MSB] = (trackNum >> 8);
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
+    // Номер трека ограничивается числом треков в выбранной папке, когда оно известно
+    const int tracks = _catalog.folderTracks(ui->folder->value());
+    if (tracks > 0)
+        ui->track->setMaximum(tracks);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Specify the playback source.
-     @param    source
-               The playback source ID.
-               1 - USB
-               2 - SD
- */
-/**************************************************************************/
-void DF_Player::playbackSource(uint8_t source)
+void DF_Player::showState()
 {
-    if (source < 1 || source > 2)
-        return;
+    selectMedia();
 
-    sendDataBuffer[CMD_VALUE] = CTRL_PLAYBACK_SRC;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = source;
-    sendData();
-}
+    ui->stateLabel->setText(tr("%1, громкость %2 | USB: файлов %3, трек %4 | SD: файлов %5, трек %6")
+                            .arg(_state.statusText(), _state.text(DFPlayerState::Volume),
+                                 _state.text(DFPlayerState::UsbFiles), _state.text(DFPlayerState::UsbTrack),
+                                 _state.text(DFPlayerState::SdFiles), _state.text(DFPlayerState::SdTrack)));
 
-/**************************************************************************/
-/*!
-     @brief  Reset all settings to factory default.
- */
-/**************************************************************************/
-void DF_Player::reset()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_RESET;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
-}
+    // Выбор в списке не должен отправлять команду обратно модулю
+    if (_state.isValid(DFPlayerState::Equalizer))
+    {
+        const QSignalBlocker blocker(ui->eq);
+        ui->eq->setCurrentIndex(_state.value(DFPlayerState::Equalizer));
+    }
 
-/**************************************************************************/
-/*!
-     @brief  Pause playing current track.
- */
-/**************************************************************************/
-void DF_Player::pause()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_PAUSE;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    const int folders = _state.value(DFPlayerState::Folders);
+    if (folders > 0)
+        ui->folder->setMaximum(folders);
+    updateTrackRange();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Play a specific track from a specific folder.
-     @param    folderNum
-               The folder number.
-     @param    trackNum
-               The track number to play.
- */
-/**************************************************************************/
-void DF_Player::playFolder(uint8_t folderNum, uint8_t trackNum)
+void DF_Player::selectMedia()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_SPEC_FOLDER;
-    sendDataBuffer[PARAM_MSB] = folderNum;
-    sendDataBuffer[PARAM_LSB] = trackNum;
-    sendData();
+    // Носитель узнаётся, когда известны число файлов и папок
+    if (_state.isValid(DFPlayerState::UsbFiles) && _state.isValid(DFPlayerState::SdFiles)
+            && _state.isValid(DFPlayerState::Folders))
+    {
+        _catalog.select(_state.value(DFPlayerState::UsbFiles), _state.value(DFPlayerState::SdFiles),
+                        _state.value(DFPlayerState::Folders));
+    }
+    else
+        _catalog.deselect();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Play a specific track from a specific folder, where the track
-             names are numbered 4 digit (e.g. 1234-mysong.mp3) and can be
-             up to 3000. Only 15 folders ("01" to "15") are supported in this
-             mode.
-     @param    folderNum
-               The folder number.
-     @param    trackNum
-               The track number to play.
- */
-/**************************************************************************/
-void DF_Player::playLargeFolder(uint8_t folderNum, uint16_t trackNum)
+void DF_Player::showCatalog()
 {
-    const uint16_t arg = (((uint16_t)folderNum) << 12) | (trackNum & 0x0FFFF);
-    sendDataBuffer[CMD_VALUE] = CTRL_SPEC_TRACK_3000;
-    sendDataBuffer[PARAM_MSB] = arg >> 8;
-    sendDataBuffer[PARAM_LSB] = arg;
-    sendData();
+    // Узлы папок создаются сразу, треки - только при раскрытии папки
+    const int folders = _catalog.folderCount();
+    while (ui->catalog->topLevelItemCount() > folders)
+        delete ui->catalog->takeTopLevelItem(ui->catalog->topLevelItemCount() - 1);
+    while (ui->catalog->topLevelItemCount() < folders)
+    {
+        QTreeWidgetItem *item = new QTreeWidgetItem(ui->catalog);
+        item->setText(0, tr("Папка %1").arg(ui->catalog->topLevelItemCount()));
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+    }
+
+    for (int folder = 1; folder <= folders; ++folder)
+        showFolder(ui->catalog->topLevelItem(folder - 1), folder);
+    updateTrackRange();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Specify volume gain.
-     @param    gain
-               The specified volume gain.
-               on - 1
-               off - 2
- */
-/**************************************************************************/
-void DF_Player::volumeAdjustSet(uint8_t on_off, uint8_t gain)
+void DF_Player::showFolder(QTreeWidgetItem *item, int folder)
 {
-    if (gain > 31 || on_off > 1)
+    const int tracks = _catalog.folderTracks(folder);
+    item->setText(1, tracks < 0 ? QStringLiteral("?") : QString::number(tracks));
+    if (tracks == 0)
+        item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+
+    if (!item->isExpanded() || tracks < 0)
         return;
 
-    sendDataBuffer[CMD_VALUE] = CTRL_AUDIO_AMPL;
-    sendDataBuffer[PARAM_MSB] = on_off;
-    sendDataBuffer[PARAM_LSB] = gain;
-    sendData();
-}
+    while (item->childCount() > tracks)
+        delete item->takeChild(item->childCount() - 1);
+    while (item->childCount() < tracks)
+    {
+        QTreeWidgetItem *child = new QTreeWidgetItem(item);
+        child->setText(0, tr("Трек %1").arg(item->childCount()));
+    }
 
-/**************************************************************************/
-/*!
-     @brief  Play all tracks.
- */
-/**************************************************************************/
-void DF_Player::startRepeatPlay()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_REPEAT_PLAY;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    for (int track = 1; track <= tracks; ++track)
+    {
+        const qint64 duration = _catalog.trackDuration(folder, track);
+        item->child(track - 1)->setText(1, duration < 0 ? QString()
+                                           : QStringLiteral("%1:%2").arg(duration / 60000)
+                                                                   .arg(duration / 1000 % 60, 2, 10, QChar('0')));
+    }
 }
 
-/**************************************************************************/
-/*!
-     @brief  Stop repeat play.
- */
-/**************************************************************************/
-void DF_Player::stopRepeatPlay()
+void DF_Player::catalogItemExpanded(QTreeWidgetItem *item)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_REPEAT_PLAY;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
+    if (item->parent())
+        return;
+
+    // Число треков запрашивается только для раскрытой папки
+    const int folder = ui->catalog->indexOfTopLevelItem(item) + 1;
+    if (_catalog.folderTracks(folder) < 0)
+        queryFolder(folder);
+    else
+        showFolder(item, folder);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Play all tracks in a given folder.
-     @param    folderNum
-               The folder number.
- */
-/**************************************************************************/
-void DF_Player::repeatFolder(uint16_t folder)
+void DF_Player::catalogItemActivated(QTreeWidgetItem *item)
 {
-    if (folder > 99)
+    if (!item->parent())
         return;
 
-    sendDataBuffer[CMD_VALUE] = CTRL_REPEAT_FOLDER;
-    sendDataBuffer[PARAM_MSB] = (folder >> 8);
-    sendDataBuffer[PARAM_LSB] = folder;
-    sendData();
+    const int folder = ui->catalog->indexOfTopLevelItem(item->parent()) + 1;
+    const int track = item->parent()->indexOfChild(item) + 1;
+    if (folder <= 99 && track <= 255)
+        send(DFPlayerCommands::PlayFolder, folder, track);
+    else
+        send(DFPlayerCommands::PlayLargeFolder, folder, track);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Play all tracks in a random order.
- */
-/**************************************************************************/
-void DF_Player::randomAll()
+void DF_Player::portReceived(const QByteArray &data, qint64 timestamp)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_RANDOM_ALL;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
-}
+    _receivedAt = timestamp;
 
-/**************************************************************************/
-/*!
-     @brief  Repeat the current track.
- */
-/**************************************************************************/
-void DF_Player::startRepeat()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_REPEAT_CURRENT;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
+    // Порция общая с окном приёма, пакеты выделяет парсер прямо в ней
+    _parser.feed(data.constData(), static_cast<size_t>(data.size()), _received,
+                 [this](const DFPlayerFrameParser::Frame &frame) { handleFrame(frame); });
+    _received += static_cast<quint64>(data.size());
 }
 
 /**************************************************************************/
 /*!
-     @brief  Stop repeat play of the current track.
+     @brief  Handle a frame found by the parser: valid frames are parsed,
+             corrupt ones are logged.
  */
 /**************************************************************************/
-void DF_Player::stopRepeat()
+void DF_Player::handleFrame(const DFPlayerFrameParser::Frame &frame)
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_REPEAT_CURRENT;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
-}
+    if (frame.status == DFPlayerFrameParser::Valid)
+    {
+        memcpy(recDataBuffer, frame.data, BUFFER_SIZE);
+        parseData();
+        return;
+    }
 
-/**************************************************************************/
-/*!
-     @brief  Turn on DAC.
- */
-/**************************************************************************/
-void DF_Player::startDAC()
-{
-    sendDataBuffer[CMD_VALUE] = CTRL_SET_DAC;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
+    _log.add(frame.status == DFPlayerFrameParser::ChecksumError ? ProtocolLog::ChecksumError : ProtocolLog::FormatError,
+             frame.data, static_cast<int>(frame.length));
+    _soak.frameRejected(frame.status);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Turn off DAC.
- */
-/**************************************************************************/
-void DF_Player::stopDAC()
+void DF_Player::on_update_clicked()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_SET_DAC;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 1;
-    sendData();
+    updateData();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Put the MP3 player into sleep mode.
- */
-/**************************************************************************/
-void DF_Player::sleep()
+void DF_Player::on_reset_clicked()
 {
-    sendDataBuffer[CMD_VALUE] = CTRL_SLEEP;
-    sendDataBuffer[PARAM_MSB] = 0;
-    sendDataBuffer[PARAM_LSB] = 0;
-    sendData();
+    send(DFPlayerCommands::Reset);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine if a track is currently playing.
- */
-/**************************************************************************/
-void DF_Player::query_isPlaying()
+
+void DF_Player::on_update_2_clicked()
 {
-    query(CMD_STATUS, 0, 0);
+    send(DFPlayerCommands::PlaybackSource, SRC_SD);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the current volume setting.
- */
 
-/**************************************************************************/
-void DF_Player::query_currentVolume()
+void DF_Player::on_playFolerTrack_clicked()
 {
-    query(CMD_VOLUME, 0, 0);
+    if (ui->num_folder->isChecked())
+        send(DFPlayerCommands::PlayLargeFolder, ui->folder->value(), ui->track->value());
+    else if(ui->folder_mp3->isChecked())
+        send(DFPlayerCommands::PlayMp3Track, ui->track->value());
+    else if(ui->folder_root->isChecked())
+        send(DFPlayerCommands::PlayTrack, ui->track->value());
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the current EQ setting.
- */
-/**************************************************************************/
-void DF_Player::query_currentEQ()
+
+void DF_Player::on_num_folder_toggled(bool checked)
 {
-    query(CMD_EQ, 0, 0);
+    ui->folder->setEnabled(checked);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the number of tracks accessible via USB.
- */
-/**************************************************************************/
-void DF_Player::query_numUsbTracks()
+void DF_Player::on_vol_inc_clicked()
 {
-    query(CMD_USB_FILES, 0, 0);
+    stepVolume(1);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the number of tracks accessible via SD card.
- */
-/**************************************************************************/
-void DF_Player::query_numSdTracks()
+
+void DF_Player::on_vol_dec_clicked()
 {
-    query(CMD_SD_FILES, 0, 0);
+    stepVolume(-1);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the current track played via USB.
- */
-/**************************************************************************/
-void DF_Player::query_currentUsbTrack()
+
+void DF_Player::on_repeate_all_clicked()
 {
-    query(CMD_USB_TRACK, 0, 0);
+    send(DFPlayerCommands::RepeatAllOn);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the current track played via SD card.
- */
-/**************************************************************************/
-void DF_Player::query_currentSdTrack()
+
+void DF_Player::on_pushButton_clicked()
 {
-    return query(CMD_SD_TRACK, 0, 0);
+    send(DFPlayerCommands::Play);
+    send(DFPlayerCommands::RepeatCurrentOn);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the number of tracks in the specified folder.
-     @param    folder
-               The folder number.
- */
-/**************************************************************************/
-void DF_Player::query_numTracksInFolder(uint16_t folder)
+void DF_Player::on_adj_accept_clicked()
 {
-    query(CMD_FOLDER_FILES, folder >> 8, folder);
+    send(DFPlayerCommands::AudioAmplifier, ui->adj_state->value(), ui->adj_gain->value());
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine the number of folders available.
- */
-/**************************************************************************/
-void DF_Player::query_numFolders()
+
+void DF_Player::on_eq_currentIndexChanged(int index)
 {
-    query(CMD_FOLDERS, 0, 0);
+    send(DFPlayerCommands::Equalizer, index);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Determine and insert the checksum of a given config/command
-             packet into that same packet struct.
-     @param    _stack
-               Reference to a struct containing the config/command packet
-               to calculate the checksum over.
- */
-/**************************************************************************/
-void DF_Player::calculateChecksum()
+void DF_Player::on_reliable_toggled(bool checked)
 {
-    uint16_t checksum = (~(sendDataBuffer[VERSION] + sendDataBuffer[LENGTH] + sendDataBuffer[CMD_VALUE] + sendDataBuffer[FEEDBAC_VALUE]
-                           + sendDataBuffer[PARAM_MSB] + sendDataBuffer[PARAM_LSB])) + 1;
-
-    sendDataBuffer[CHECKSUM_MSB] = checksum >> 8;
-    sendDataBuffer[CHECKSUM_LSB] = checksum;
+    _engine.commands().setReliable(checked);
+    showLinkStatistics();
 }
 
-/**************************************************************************/
-/*!
-     @brief  Send a config/command packet to the MP3 player.
- */
-/**************************************************************************/
-void DF_Player::sendData()
+void DF_Player::on_logLevel_currentIndexChanged(int index)
 {
-    _serial.flush();
-    QThread::msleep(100);
-    sendDataBuffer[START_BYTE] = SB;
-    sendDataBuffer[VERSION] = VER;
-    sendDataBuffer[LENGTH] = LEN;
-    sendDataBuffer[FEEDBAC_VALUE] = NO_FEEDBACK;
-    calculateChecksum();
-    sendDataBuffer[END_BYTE] = EB;
-
-    _serial.write(reinterpret_cast<char *>(sendDataBuffer), BUFFER_SIZE);
-
-    printf("Data send -> ");
-    printBuff(sendDataBuffer, BUFFER_SIZE);
-    printf("\n");
-    fflush(stdout);
+    _log.setLevel(static_cast<ProtocolLog::Level>(index));
 }
 
-/**************************************************************************/
-/*!
-     @brief  Query the MP3 player for specific information.
-     @param    cmd
-               The command/query ID.
-     @param    msb
-               The payload/parameter MSB.
-     @param    lsb
-               The payload/parameter LSB.
- */
-/**************************************************************************/
-void DF_Player::query(uint8_t cmd, uint8_t msb, uint8_t lsb)
+void DF_Player::showLog(const QStringList &lines)
 {
-    sendDataBuffer[START_BYTE] = SB;
-    sendDataBuffer[VERSION] = VER;
-    sendDataBuffer[LENGTH] = LEN;
-    sendDataBuffer[CMD_VALUE] = cmd;
-    sendDataBuffer[FEEDBAC_VALUE] = NO_FEEDBACK;
-    sendDataBuffer[PARAM_MSB] = msb;
-    sendDataBuffer[PARAM_LSB] = lsb;
-    calculateChecksum();
-    sendDataBuffer[END_BYTE] = EB;
-
-    sendData();
+    for (const QString &line : lines)
+        ui->log->appendPlainText(line);
 }
 
-/**************************************************************************/
-/*!
-     @brief  Parse MP3 player query responses.
- */
-/**************************************************************************/
-
-void DF_Player::parseData()
+void DF_Player::on_soakStart_toggled(bool checked)
 {
-    if (recDataBufferSize < BUFFER_SIZE)
-        return;
-
-    if (recDataBuffer[START_BYTE] != SB && recDataBuffer[END_BYTE] != EB)
+    if (!checked)
     {
-        printf("Recive unknow data. Data in rec buffer: ");
-        printBuff(recDataBuffer, recDataBufferSize);
-        printf("\n");
-
-        // Смещаем буфер влево, отбрасывая первый байт
-        memmove(recDataBuffer, &recDataBuffer[1], BUFFER_SIZE - 1);
-        recDataBufferSize--;
+        _soak.stop();
         return;
     }
 
-    printf("Data recive <- ");
-    printBuff(recDataBuffer, recDataBufferSize);
-    printf(" - ");
-
-#define MSB recDataBuffer[PARAM_MSB]
-#define LSB recDataBuffer[PARAM_LSB]
+    // Время отклика команд управления измеряется до подтверждения 0x41
+    ui->reliable->setChecked(true);
 
-    switch (recDataBuffer[CMD_VALUE])
-    {
-    case CMD_CUR_DEV_ONLINE:
-        if (LSB == 0x01)
-            printf("USB flash drive online\n");
-        else if (LSB == 0x02)
-            printf("SD card online\n");
-        else if (LSB == 0x03)
-            printf("PC online\n");
-        else if (LSB == 0x04)
-            printf("USB flash drive and SD card online\n");
-        break;
-    case CMD_ERROR:
-        printError();
-        break;
-    case CMD_FEEDBACK:
-        if (MSB == 0 && LSB == 0)
-            printf("Module has successfully received the command\n");
-        break;
-    case CMD_STATUS:
-        if (MSB == 0 || MSB == 1)  // 1 || 2
-        {
-            printf("A track in %s is %s\n",
-                   (MSB == 1) ? "USB" : "SD",
-                   (LSB == 0) ? "stopped" : (LSB == 1) ? "playing" : "paused");
-        }
-        else if (MSB == 0x10)
-            printf("Module in sleep mode\n");
-        break;
-    case CMD_VOLUME:
-        printf("Volume is %d\n", LSB);
-        curr_vol = LSB;
-        break;
-    case CMD_EQ:
-        printf("EQ is %d\n", LSB);
-        curr_eq = LSB;
-        ui->eq->setCurrentIndex(LSB);
-        break;
-
-    case CMD_USB_FILES:
-        num_USB_tracks = ((uint16_t)MSB << 8) | LSB;
-        printf("Files in USB: %d\n", num_USB_tracks);
-        break;
-    case CMD_SD_FILES:
-        num_SD_tracks = ((uint16_t)MSB << 8) | LSB;
-        printf("Files in SD: %d\n", num_SD_tracks);
-        break;
-
-    case CMD_USB_TRACK:
-        curr_USB_track = ((uint16_t)MSB << 8) | LSB;
-        printf("The track %d in USB being played\n", curr_USB_track);
-        break;
-    case CMD_SD_TRACK:
-        curr_SD_track = ((uint16_t)MSB << 8) | LSB;
-        printf("The track %d in SD being played\n", curr_SD_track);
-        break;
-
-    case CMD_FOLDER_FILES:
-        printf("%d track in folder\n", ((uint16_t)MSB << 8) | LSB);
-        break;
-    case CMD_FOLDERS:
-        num_folders = ((uint16_t)MSB << 8) | LSB;
-        printf("%d folders in current device\n", num_folders);
-        break;
-
-    case CMD_DEV_PLUGGED:
-        if (LSB == 1)
-            printf("USB flash drive is plugged in\n");
-        else if (LSB == 2)
-            printf("SD card is plugged in\n");
-        else if (LSB == 4)
-            printf("USB cable connected to PC is plugged in\n");
-        break;
-    case CMD_DEV_PULL_OUT:
-        if (LSB == 1)
-            printf("USB flash drive is pulled out\n");
-        else if (LSB == 2)
-            printf("SD card is pulled out\n");
-        else if (LSB == 4)
-            printf("USB cable connected to PC is pulled out\n");
-        break;
-    case CMD_TRACK_FINSH_USB:
-        printf("%d track is finished playing in USB flash drive\n", ((uint16_t)MSB << 8) | LSB);
-        break;
-    case CMD_TRACK_FINSH_SD:
-        printf("%d track is finished playing in SD card\n", ((uint16_t)MSB << 8) | LSB);
-        break;
-    default:
-        printf("In recive unknow data.\n");
-    }
-
-    fflush(stdout);
+    DFPlayerSoakTest::Settings settings;
+    settings.queryPercent = ui->soakQueries->value();
+    settings.transport = ui->soakTransport->isChecked();
+    settings.durationMinutes = ui->soakDuration->value();
+    _soak.start(settings);
+}
 
-    recDataBufferSize = 0;
+void DF_Player::on_soakReport_clicked()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Отчёт нагрузочного теста"), QString(),
+                                                          tr("Текст (*.txt)"));
+    if (fileName.isEmpty())
+        return;
 
-#undef MSB
-#undef LSB
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+            || file.write(_soak.report().toUtf8()) < 0 || !file.commit())
+        QMessageBox::critical(this, tr("Error"), file.errorString());
 }
 
-/**************************************************************************/
-/*!
-     @brief  Print the error description if an error has been received
- */
-/**************************************************************************/
-void DF_Player::printError()
+void DF_Player::showPlaylist()
 {
-    if (recDataBuffer[CMD_VALUE] == CMD_ERROR)
+    ui->playlist->clear();
+    for (const DFPlayerPlaylist::Entry &entry : _playlist.entries())
     {
-        switch (recDataBuffer[PARAM_LSB])
-        {
-        case 0x1:
-        {
-            printf("Module busy (this info is returned when the initialization is not done)");
-            break;
-        }
-        case 0x2:
-        {
-            printf("Currently sleep mode(supports only specified device in sleep mode)");
-            break;
-        }
-        case 0x3:
-        {
-            printf("Serial receiving error(a frame has not been received completely yet)");
-            break;
-        }
-        case 0x4:
-        {
-            printf("Checksum incorrect");
-            break;
-        }
-        case 0x5:
-        {
-            printf("Specified track is out of current track scope");
-            break;
-        }
-        case 0x6:
-        {
-            printf("Specified track is not found");
-            break;
-        }
-        case 0x7:
-        {
-            printf("Insertion error(an inserting operation only can be done when a track is being played)");
-            break;
-        }
-        case 0x8:
-        {
-            printf("SD card reading failed(SD card pulled out or damaged)");
-            break;
-        }
-        case 0xA:
-        {
-            printf("Entered into sleep mode");
-            break;
-        }
-        default:
-        {
-            printf("Unknown error: %d", recDataBuffer[PARAM_LSB]);
-            break;
-        }
-        }
+        ui->playlist->addItem(entry.folder == 0 ? tr("Файл %1").arg(entry.track)
+                                                : tr("Папка %1, трек %2").arg(entry.folder).arg(entry.track));
     }
-    else
-        printf("No error");
-
-    printf("\n");
-    fflush(stdout);
+    const QSignalBlocker blocker(ui->playlist);
+    ui->playlist->setCurrentRow(_playlist.current());
 }
 
-void DF_Player::printBuff(uint8_t *data, uint8_t size)
+void DF_Player::showGaps()
 {
-    for (int i = 0; i < size - 1; ++i)
-        printf("%02X:", data[i]);
-    printf("%02X", data[size - 1]);
+    const DFPlayerPlaylist::GapStatistics &gaps = _playlist.gaps();
+    const double msPerNs = 1e-6;
+    ui->playlistStatus->setText(tr("пауза %1 мс (%2..%3, среднее %4, переходов %5)")
+                                .arg(gaps.lastNs * msPerNs, 0, 'f', 2)
+                                .arg(gaps.minNs * msPerNs, 0, 'f', 2)
+                                .arg(gaps.maxNs * msPerNs, 0, 'f', 2)
+                                .arg(gaps.totalNs * msPerNs / gaps.samples, 0, 'f', 2)
+                                .arg(gaps.samples));
 }
 
-void DF_Player::updateData()
+void DF_Player::on_playlistStart_toggled(bool checked)
 {
-    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-    volumeAdjustSet(0, 0);
-
-    query_isPlaying();
-    query_currentVolume();
-    query_currentEQ();
-    query_numUsbTracks();
-    query_numSdTracks();
-    query_currentUsbTrack();
-    query_currentSdTrack();
-    query_numFolders();
-
-    for (int i = 1; i <= num_folders; ++i)
+    if (!checked)
     {
-        query_numTracksInFolder(i);
+        if (_playlist.isActive())
+        {
+            _playlist.stop();
+            send(DFPlayerCommands::Stop);
+        }
+        return;
     }
 
-
-    QGuiApplication::restoreOverrideCursor();
-}
-
-void DF_Player::dataRecive()
-{
-    char byte;
-    while (_serial.bytesAvailable())
+    if (!_playlist.start(qMax(0, ui->playlist->currentRow())))
     {
-        _serial.read(&byte, 1);
-
-        recDataBuffer[recDataBufferSize] = byte;
-        recDataBufferSize++;
-        if (recDataBufferSize == BUFFER_SIZE)
-            parseData();
+        const QSignalBlocker blocker(ui->playlistStart);
+        ui->playlistStart->setChecked(false);
+        return;
     }
+    ui->playlistStatus->clear();
 }
 
-void DF_Player::on_update_clicked()
-{
-    updateData();
-}
-
-void DF_Player::on_reset_clicked()
-{
-    reset();
-}
-
-
-void DF_Player::on_update_2_clicked()
-{
-    playbackSource(2);
-}
-
-
-void DF_Player::on_playFolerTrack_clicked()
+void DF_Player::on_playlistAdd_clicked()
 {
-    if (ui->num_folder->isChecked())
-        playLargeFolder(ui->folder->value(), ui->track->value());
-    else if(ui->folder_mp3->isChecked())
-        playFromMP3Folder(ui->track->value());
-    else if(ui->folder_root->isChecked())
-        playFromRootFolder(ui->track->value());
-}
-
-
-void DF_Player::on_num_folder_toggled(bool checked)
-{
-    ui->folder->setEnabled(checked);
-}
-
-void DF_Player::on_vol_inc_clicked()
-{
-    incVolume();
-    query_currentVolume();
-}
+    QTreeWidgetItem *item = ui->catalog->currentItem();
+    if (!item)
+        return;
 
+    std::vector<DFPlayerPlaylist::Entry> entries = _playlist.entries();
+    std::vector<DFPlayerPlaylist::Entry> added;
+    if (item->parent())
+    {
+        added.push_back({ui->catalog->indexOfTopLevelItem(item->parent()) + 1, item->parent()->indexOfChild(item) + 1});
+    }
+    else
+    {
+        // Папка добавляется целиком, когда известно число треков в ней
+        const int folder = ui->catalog->indexOfTopLevelItem(item) + 1;
+        const int tracks = _catalog.folderTracks(folder);
+        if (tracks < 0)
+        {
+            queryFolder(folder);
+            ui->playlistStatus->setText(tr("число треков папки %1 запрошено, повторите").arg(folder));
+            return;
+        }
+        for (int track = 1; track <= tracks; ++track)
+            added.push_back({folder, track});
+    }
 
-void DF_Player::on_vol_dec_clicked()
-{
-    decVolume();
-    query_currentVolume();
+    // Треки, которые не адресует ни одна команда (папки 16..99 после 255-го), не добавляются
+    int skipped = 0;
+    for (const DFPlayerPlaylist::Entry &entry : added)
+    {
+        if (DFPlayerPlaylist::isPlayable(entry))
+            entries.push_back(entry);
+        else
+            skipped++;
+    }
+    _playlist.setEntries(entries);
+    showPlaylist();
+    if (skipped)
+        ui->playlistStatus->setText(tr("не добавлено треков: %1 - номер вне диапазона команд").arg(skipped));
 }
 
-
-void DF_Player::on_repeate_all_clicked()
+void DF_Player::on_playlistRemove_clicked()
 {
-    startRepeatPlay();
+    std::vector<DFPlayerPlaylist::Entry> entries;
+    for (int row = 0; row < static_cast<int>(_playlist.entries().size()); ++row)
+    {
+        if (!ui->playlist->item(row)->isSelected())
+            entries.push_back(_playlist.entries()[row]);
+    }
+    _playlist.setEntries(entries);
+    showPlaylist();
 }
 
-
-void DF_Player::on_pushButton_clicked()
+void DF_Player::on_playlistClear_clicked()
 {
-    play(0);
-    startRepeat();
+    _playlist.setEntries({});
+    showPlaylist();
 }
 
-void DF_Player::on_adj_accept_clicked()
+void DF_Player::on_playlistShuffle_toggled(bool checked)
 {
-    volumeAdjustSet(ui->adj_state->value(), ui->adj_gain->value());
+    _playlist.setShuffle(checked);
 }
 
-
-void DF_Player::on_eq_currentIndexChanged(int index)
+void DF_Player::on_playlistRepeat_toggled(bool checked)
 {
-    EQSelect(index);
+    _playlist.setRepeat(checked);
 }
 
-
-void DF_Player::on_isPlay_clicked()
+void DF_Player::on_playlistAnnounce_clicked()
 {
-    query_isPlaying();
+    if (!_playlist.announce(ui->advert->value()))
+        send(DFPlayerCommands::PlayAdvertisement, ui->advert->value());
 }
-
@@ -0,0 +1,212 @@
+#include "dfplayercatalog.h"
+#include "dfplayercommands.h"
+#include "monotonicclock.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+DFPlayerCatalog::DFPlayerCatalog(const QString &fileName, QObject *parent)
+    : QObject(parent),
+      _fileName(fileName)
+{
+    load();
+}
+
+QString DFPlayerCatalog::defaultFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/dfplayer-catalog.json");
+}
+
+bool DFPlayerCatalog::load()
+{
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QJsonObject media = QJsonDocument::fromJson(file.readAll()).object();
+    _media.clear();
+    _current = nullptr;
+    for (auto it = media.begin(); it != media.end(); ++it)
+    {
+        Media &folders = _media[it.key()];
+        for (const QJsonValue &value : it.value().toArray())
+        {
+            const QJsonObject object = value.toObject();
+            Folder entry;
+            entry.tracks = object.value(QStringLiteral("tracks")).toInt(-1);
+
+            const QJsonObject durations = object.value(QStringLiteral("durations")).toObject();
+            for (auto duration = durations.begin(); duration != durations.end(); ++duration)
+                entry.durations[duration.key().toInt()] = static_cast<qint64>(duration.value().toDouble());
+            folders.push_back(entry);
+        }
+    }
+    _modified = false;
+    return true;
+}
+
+bool DFPlayerCatalog::save()
+{
+    if (!_modified)
+        return true;
+
+    QJsonObject media;
+    for (const auto &entry : _media)
+    {
+        QJsonArray folders;
+        for (const Folder &folder : entry.second)
+        {
+            QJsonObject durations;
+            for (const auto &duration : folder.durations)
+                durations.insert(QString::number(duration.first), static_cast<double>(duration.second));
+
+            QJsonObject object;
+            object.insert(QStringLiteral("tracks"), folder.tracks);
+            if (!durations.isEmpty())
+                object.insert(QStringLiteral("durations"), durations);
+            folders.append(object);
+        }
+        media.insert(entry.first, folders);
+    }
+
+    QDir().mkpath(QFileInfo(_fileName).absolutePath());
+    QSaveFile file(_fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(QJsonDocument(media).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        return false;
+
+    _modified = false;
+    return true;
+}
+
+bool DFPlayerCatalog::select(int usbFiles, int sdFiles, int folders)
+{
+    const QString key = QStringLiteral("usb%1-sd%2-folders%3").arg(usbFiles).arg(sdFiles).arg(folders);
+    const bool known = _media.count(key) != 0;
+
+    Media &media = _media[key];
+    if (&media == _current)
+        return known;
+
+    media.resize(static_cast<size_t>(qMax(0, folders)));
+    _current = &media;
+    emit changed();
+    return known;
+}
+
+void DFPlayerCatalog::deselect()
+{
+    if (!_current)
+        return;
+
+    _current = nullptr;
+    _playingFolder = 0;
+    emit changed();
+}
+
+bool DFPlayerCatalog::isSelected() const
+{
+    return _current != nullptr;
+}
+
+int DFPlayerCatalog::folderCount() const
+{
+    return _current ? static_cast<int>(_current->size()) : 0;
+}
+
+int DFPlayerCatalog::folderTracks(int number) const
+{
+    const Folder *entry = folder(number);
+    return entry ? entry->tracks : -1;
+}
+
+void DFPlayerCatalog::setFolderTracks(int number, int tracks)
+{
+    Folder *entry = folder(number);
+    if (!entry || entry->tracks == tracks)
+        return;
+
+    entry->tracks = tracks;
+    _modified = true;
+    emit changed();
+}
+
+qint64 DFPlayerCatalog::trackDuration(int number, int track) const
+{
+    const Folder *entry = folder(number);
+    if (!entry)
+        return -1;
+
+    const auto it = entry->durations.find(track);
+    return it == entry->durations.end() ? -1 : it->second;
+}
+
+void DFPlayerCatalog::commandSent(quint8 opcode, quint16 param, qint64 timestamp)
+{
+    switch (opcode)
+    {
+    case CTRL_SPEC_FOLDER:
+        _playingFolder = param >> 8;
+        _playingTrack = param & 0xFF;
+        _playStarted = timestamp;
+        break;
+    case CTRL_SPEC_TRACK_3000:
+        _playingFolder = param >> 12;
+        _playingTrack = param & 0x0FFF;
+        _playStarted = timestamp;
+        break;
+
+    // Громкость, эквалайзер и т.п. не влияют на время воспроизведения
+    case CTRL_INC_VOL:
+    case CTRL_DEC_VOL:
+    case CTRL_VOLUME:
+    case CTRL_EQ:
+    case CTRL_AUDIO_AMPL:
+    case CTRL_SET_DAC:
+        break;
+
+    default:
+        // Запросы не прерывают трек, остальные команды меняют воспроизведение - измерение неточно
+        if (opcode < CMD_DEV_PLUGGED)
+            _playingFolder = 0;
+        break;
+    }
+}
+
+void DFPlayerCatalog::messageReceived(quint8 opcode, qint64 timestamp)
+{
+    if (opcode != CMD_TRACK_FINSH_USB && opcode != CMD_TRACK_FINSH_SD)
+        return;
+
+    // Модуль может сообщить об окончании дважды - учитывается первое
+    Folder *entry = _playingFolder ? folder(_playingFolder) : nullptr;
+    _playingFolder = 0;
+    if (!entry)
+        return;
+
+    entry->durations[_playingTrack] = (timestamp - _playStarted) / MonotonicClock::NS_PER_MS;
+    _modified = true;
+    emit changed();
+}
+
+DFPlayerCatalog::Folder *DFPlayerCatalog::folder(int number)
+{
+    if (!_current || number < 1 || number > static_cast<int>(_current->size()))
+        return nullptr;
+    return &(*_current)[static_cast<size_t>(number - 1)];
+}
+
+const DFPlayerCatalog::Folder *DFPlayerCatalog::folder(int number) const
+{
+    if (!_current || number < 1 || number > static_cast<int>(_current->size()))
+        return nullptr;
+    return &(*_current)[static_cast<size_t>(number - 1)];
+}
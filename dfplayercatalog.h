@@ -0,0 +1,70 @@
+#ifndef DFPLAYERCATALOG_H
+#define DFPLAYERCATALOG_H
+
+#include <QObject>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+// Каталог носителей DFPlayer: число треков в папках и длительности треков, измеренные
+// от команды воспроизведения до сообщения CMD_TRACK_FINSH_*.
+// Носитель узнаётся по числу файлов на USB и SD и числу папок; каталог сохраняется на диск,
+// поэтому для неизменной карты перечисление папок не повторяется.
+// Число треков в папке запрашивается по требованию, каталог хранит только ответы.
+class DFPlayerCatalog : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DFPlayerCatalog(const QString &fileName = defaultFileName(), QObject *parent = nullptr);
+
+    static QString defaultFileName();
+
+    bool load();
+    bool save();
+
+    // Выбрать носитель; true, если для него уже есть сохранённые данные
+    bool select(int usbFiles, int sdFiles, int folders);
+    void deselect();
+    bool isSelected() const;
+
+    int folderCount() const;
+    // Число треков в папке (с 1), -1 - неизвестно
+    int folderTracks(int folder) const;
+    void setFolderTracks(int folder, int tracks);
+    // Длительность трека в мс, -1 - ещё не измерена
+    qint64 trackDuration(int folder, int track) const;
+
+    // Измерение длительностей: команды записаны в порт и сообщения модуля
+    void commandSent(quint8 opcode, quint16 param, qint64 timestamp);
+    void messageReceived(quint8 opcode, qint64 timestamp);
+
+signals:
+    void changed();
+
+private:
+    struct Folder
+    {
+        int tracks = -1;
+        std::map<int, qint64> durations;
+    };
+
+    using Media = std::vector<Folder>;
+
+    Folder *folder(int number);
+    const Folder *folder(int number) const;
+
+    QString _fileName;
+    std::map<QString, Media> _media;
+    // Выбранный носитель, nullptr - не выбран
+    Media *_current = nullptr;
+    bool _modified = false;
+
+    // Трек, запущенный командой с известной папкой; 0 - измерение не идёт
+    int _playingFolder = 0;
+    int _playingTrack = 0;
+    qint64 _playStarted = 0;
+};
+
+#endif // DFPLAYERCATALOG_H
@@ -0,0 +1,354 @@
+#include "dfplayercommandqueue.h"
+#include "dfplayercommands.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+#include <iterator>
+
+DFPlayerCommandQueue::DFPlayerCommandQueue(PortDispatcher &port, QObject *parent)
+    : QObject(parent),
+      _port(port)
+{
+    // Паузы по документации модуля: ~30 мс между командами, ответ на запрос приходит до 50 мс,
+    // смена носителя - около 200 мс, инициализация после сброса - до 1.5 с
+    _delays[Control] = 30;
+    _delays[Query] = 50;
+    _delays[Source] = 200;
+    _delays[Reset] = 1500;
+
+    _pause.setSingleShot(true);
+    connect(&_pause, &QTimer::timeout, this, &DFPlayerCommandQueue::sendNext);
+    _ackTimer.setSingleShot(true);
+    connect(&_ackTimer, &QTimer::timeout, this, &DFPlayerCommandQueue::retransmitAll);
+    connect(&_port, &PortDispatcher::bytesWritten, this, &DFPlayerCommandQueue::handleBytesWritten);
+}
+
+DFPlayerCommandQueue::CommandClass DFPlayerCommandQueue::classOf(quint8 command)
+{
+    if (command == CTRL_RESET)
+        return Reset;
+    if (command == CTRL_PLAYBACK_SRC)
+        return Source;
+    if (command >= CMD_DEV_PLUGGED && command <= CMD_FOLDERS)
+        return Query;
+    return Control;
+}
+
+DFPlayerCommandQueue::Priority DFPlayerCommandQueue::priorityOf(quint8 command)
+{
+    switch (command)
+    {
+    case CTRL_NEXT:
+    case CTRL_PREV:
+    case CTRL_SPEC_PLAY:
+    case CTRL_PLAYBACK_SRC:
+    case CTRL_SLEEP:
+    case CTRL_RESET:
+    case CTRL_PLAY:
+    case CTRL_PAUSE:
+    case CTRL_SPEC_FOLDER:
+    case CTRL_SPEC_PLAY_MP3:
+    case CTRL_INSERT_ADVERT:
+    case CTRL_SPEC_TRACK_3000:
+    case CTRL_STOP_ADVERT:
+    case CTRL_STOP:
+        return Transport;
+    default:
+        return classOf(command) == Query ? Background : Setting;
+    }
+}
+
+bool DFPlayerCommandQueue::isCoalesced(quint8 command)
+{
+    return command == CTRL_VOLUME || command == CTRL_EQ || command == CTRL_AUDIO_AMPL || command == CTRL_SET_DAC;
+}
+
+void DFPlayerCommandQueue::setDelay(CommandClass commandClass, int milliseconds)
+{
+    _delays[commandClass] = qMax(0, milliseconds);
+}
+
+int DFPlayerCommandQueue::delay(CommandClass commandClass) const
+{
+    return _delays[commandClass];
+}
+
+void DFPlayerCommandQueue::setFrameTime(qint64 nanoseconds)
+{
+    _frameTimeNs = qMax<qint64>(0, nanoseconds);
+}
+
+qint64 DFPlayerCommandQueue::frameTimeOf(const SettingsDialog::Settings &settings)
+{
+    return BUFFER_SIZE * SettingsDialog::byteDurationNs(settings);
+}
+
+void DFPlayerCommandQueue::enqueue(const QByteArray &frame)
+{
+    // Пустой пакет - параметры вне допустимых значений, в порт не идёт
+    if (frame.size() != BUFFER_SIZE)
+        return;
+
+    const quint8 command = static_cast<quint8>(frame[CMD_VALUE]);
+    std::deque<QByteArray> &frames = _frames[priorityOf(command)];
+
+    // Новое значение заменяет ещё не отправленное на его месте в очереди
+    auto it = frames.end();
+    if (isCoalesced(command))
+    {
+        it = std::find_if(frames.begin(), frames.end(),
+                          [command](const QByteArray &pending) { return static_cast<quint8>(pending[CMD_VALUE]) == command; });
+    }
+    if (it != frames.end())
+        *it = frame;
+    else
+        frames.push_back(frame);
+
+    // Порт свободен и пауза выдержана - пакет уходит сразу
+    if (isReady())
+        sendNext();
+}
+
+void DFPlayerCommandQueue::enqueueFirst(const QByteArray &frame)
+{
+    if (frame.size() != BUFFER_SIZE)
+        return;
+
+    // Впереди только повторы: они уже были отправлены раньше
+    _frames[Transport].push_front(frame);
+    if (isReady())
+        sendNext();
+}
+
+void DFPlayerCommandQueue::clear()
+{
+    for (std::deque<QByteArray> &frames : _frames)
+        frames.clear();
+    _retransmit.clear();
+    _unacknowledged.clear();
+    _ackTimer.stop();
+    // Порт мог закрыться до bytesWritten последнего пакета - иначе после открытия очередь не писала бы
+    _draining = false;
+    _pause.stop();
+}
+
+int DFPlayerCommandQueue::pending() const
+{
+    size_t count = 0;
+    for (const std::deque<QByteArray> &frames : _frames)
+        count += frames.size();
+    return static_cast<int>(count);
+}
+
+int DFPlayerCommandQueue::pendingParameter(quint8 command) const
+{
+    for (const QByteArray &frame : _frames[priorityOf(command)])
+    {
+        if (static_cast<quint8>(frame[CMD_VALUE]) == command)
+            return (static_cast<quint8>(frame[PARAM_MSB]) << 8) | static_cast<quint8>(frame[PARAM_LSB]);
+    }
+    return -1;
+}
+
+void DFPlayerCommandQueue::setReliable(bool reliable)
+{
+    _reliable = reliable;
+    if (reliable)
+        return;
+
+    // Ожидающие подтверждения больше не повторяются
+    _unacknowledged.clear();
+    _retransmit.clear();
+    _ackTimer.stop();
+    if (isReady())
+        sendNext();
+}
+
+bool DFPlayerCommandQueue::isReliable() const
+{
+    return _reliable;
+}
+
+void DFPlayerCommandQueue::setWindow(int frames)
+{
+    _window = qMax(1, frames);
+}
+
+void DFPlayerCommandQueue::setAckTimeout(int milliseconds)
+{
+    _ackTimeout = qMax(1, milliseconds);
+}
+
+void DFPlayerCommandQueue::setMaxRetries(int retries)
+{
+    _maxRetries = qMax(0, retries);
+}
+
+void DFPlayerCommandQueue::handleAck()
+{
+    if (_unacknowledged.empty())
+        return;
+
+    // Модуль подтверждает пакеты по порядку
+    const Unacknowledged acknowledged = _unacknowledged.front();
+    _unacknowledged.pop_front();
+    ++_statistics.acknowledged;
+
+    // Время до подтверждения повторённого пакета неоднозначно и не учитывается
+    qint64 rtt = -1;
+    if (acknowledged.attempts == 0)
+    {
+        rtt = MonotonicClock::nowNs() - acknowledged.sentAt;
+        _statistics.minRttNs = _statistics.rttSamples ? qMin(_statistics.minRttNs, rtt) : rtt;
+        _statistics.maxRttNs = qMax(_statistics.maxRttNs, rtt);
+        _statistics.totalRttNs += rtt;
+        ++_statistics.rttSamples;
+    }
+    emit frameAcknowledged(acknowledged.frame, rtt);
+    emit statisticsChanged();
+
+    scheduleAckTimeout();
+    if (isReady())
+        sendNext();
+}
+
+bool DFPlayerCommandQueue::handleError(quint16 code)
+{
+    // 0x3 - пакет принят не полностью, 0x4 - неверная контрольная сумма
+    if (!_reliable || _unacknowledged.empty() || (code != 0x3 && code != 0x4))
+        return false;
+
+    retransmitAll();
+    return true;
+}
+
+const DFPlayerCommandQueue::Statistics &DFPlayerCommandQueue::statistics() const
+{
+    return _statistics;
+}
+
+void DFPlayerCommandQueue::sendNext()
+{
+    // Повторы идут первыми, в исходном порядке
+    if (!_retransmit.empty())
+    {
+        Unacknowledged entry = _retransmit.front();
+        _retransmit.pop_front();
+
+        const qint64 now = MonotonicClock::nowNs();
+        entry.sentAt = now;
+        entry.deadline = now + _frameTimeNs + (static_cast<qint64>(_ackTimeout) << entry.attempts) * MonotonicClock::NS_PER_MS;
+        _unacknowledged.push_back(entry);
+        scheduleAckTimeout();
+
+        write(entry.frame);
+        emit frameRetransmitted(entry.frame, entry.attempts);
+        return;
+    }
+
+    // Окно заполнено - следующая команда ждёт подтверждения
+    if (_reliable && static_cast<int>(_unacknowledged.size()) >= _window)
+        return;
+
+    auto frames = std::find_if(std::begin(_frames), std::end(_frames),
+                               [](const std::deque<QByteArray> &queue) { return !queue.empty(); });
+    if (frames == std::end(_frames))
+    {
+        if (_unacknowledged.empty())
+            emit idle();
+        return;
+    }
+
+    QByteArray frame = frames->front();
+    frames->pop_front();
+
+    const quint8 command = frame.size() > CMD_VALUE ? static_cast<quint8>(frame[CMD_VALUE]) : 0;
+    if (_reliable && classOf(command) != Query)
+    {
+        frame = DFPlayerCommands::withFeedback(frame);
+        const qint64 now = MonotonicClock::nowNs();
+        _unacknowledged.push_back({frame, now, now + _frameTimeNs + _ackTimeout * MonotonicClock::NS_PER_MS, 0});
+        scheduleAckTimeout();
+    }
+
+    write(frame);
+    emit frameSent(frame);
+}
+
+void DFPlayerCommandQueue::write(const QByteArray &frame)
+{
+    _lastClass = classOf(frame.size() > CMD_VALUE ? static_cast<quint8>(frame[CMD_VALUE]) : 0);
+    _draining = true;
+    _sentAt = MonotonicClock::nowNs();
+    _port.write(frame);
+
+    // Порт без буфера записи (или у читателя в отдельном потоке) не сообщит bytesWritten позже
+    if (_port.bytesToWrite() == 0)
+        startPause();
+}
+
+void DFPlayerCommandQueue::startPause()
+{
+    _draining = false;
+
+    // Драйвер мог принять пакет в буфер раньше, чем он передан по линии
+    const qint64 onWire = qMax<qint64>(0, _sentAt + _frameTimeNs - MonotonicClock::nowNs());
+    _pause.start(_delays[_lastClass] + static_cast<int>((onWire + MonotonicClock::NS_PER_MS - 1) / MonotonicClock::NS_PER_MS));
+}
+
+void DFPlayerCommandQueue::handleBytesWritten()
+{
+    // Пауза отсчитывается с момента, когда пакет целиком ушёл в порт
+    if (_draining && _port.bytesToWrite() == 0)
+        startPause();
+}
+
+void DFPlayerCommandQueue::retransmitAll()
+{
+    if (_unacknowledged.empty())
+        return;
+
+    // Подтверждения не нумерованы: после потери повторяются все неподтверждённые пакеты по порядку
+    std::deque<Unacknowledged> entries;
+    entries.swap(_unacknowledged);
+    _ackTimer.stop();
+
+    for (Unacknowledged &entry : entries)
+    {
+        if (entry.attempts >= _maxRetries)
+        {
+            ++_statistics.failed;
+            emit frameFailed(entry.frame);
+            continue;
+        }
+
+        ++entry.attempts;
+        ++_statistics.retransmits;
+        _retransmit.push_back(entry);
+    }
+    emit statisticsChanged();
+
+    if (isReady())
+        sendNext();
+}
+
+void DFPlayerCommandQueue::scheduleAckTimeout()
+{
+    if (_unacknowledged.empty())
+    {
+        _ackTimer.stop();
+        return;
+    }
+
+    qint64 nearest = _unacknowledged.front().deadline;
+    for (const Unacknowledged &entry : _unacknowledged)
+        nearest = qMin(nearest, entry.deadline);
+
+    const qint64 wait = qMax<qint64>(0, nearest - MonotonicClock::nowNs());
+    _ackTimer.start(static_cast<int>((wait + MonotonicClock::NS_PER_MS - 1) / MonotonicClock::NS_PER_MS));
+}
+
+bool DFPlayerCommandQueue::isReady() const
+{
+    return !_draining && !_pause.isActive();
+}
@@ -0,0 +1,153 @@
+#ifndef DFPLAYERCOMMANDQUEUE_H
+#define DFPLAYERCOMMANDQUEUE_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTimer>
+
+#include <deque>
+
+#include "portdispatcher.h"
+
+// Очередь пакетов для DFPlayer: пакеты уходят по одному, следующий - не раньше, чем предыдущий
+// полностью передан в порт и выдержана пауза, нужная модулю для команд этого класса.
+// Ожидание - таймером, цикл событий не блокируется.
+// Команды воспроизведения идут вперёд настроек, настройки - вперёд запросов; ещё не отправленная
+// настройка (громкость, эквалайзер...) заменяется новой того же кода, а не ставится следом.
+// Время передачи пакета по линии учитывается, даже если драйвер принял его в свой буфер сразу.
+// В режиме подтверждения команды уходят с битом FEEDBACK, модуль отвечает 0x41 по порядку;
+// без подтверждения за время ожидания (или при ошибке приёма 0x3/0x4) все неподтверждённые
+// пакеты передаются заново (go-back-N) с удвоением времени ожидания. Запросы не подтверждаются -
+// их ответы ждёт DFPlayerQueries.
+class DFPlayerCommandQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum CommandClass
+    {
+        Control,    // управление воспроизведением и громкостью
+        Query,      // запросы состояния (0x3A..0x4F)
+        Source,     // выбор носителя - модуль заново читает носитель
+        Reset,      // сброс - модуль инициализируется заново
+        CommandClassCount
+    };
+
+    enum Priority
+    {
+        Transport,  // воспроизведение, выбор носителя, сброс - порядок между ними сохраняется
+        Setting,    // громкость, эквалайзер, режимы повтора
+        Background, // запросы
+        PriorityCount
+    };
+
+    struct Statistics
+    {
+        quint64 acknowledged = 0;
+        quint64 retransmits = 0;
+        quint64 failed = 0;         // не подтверждены после всех повторов
+        // Время до подтверждения, только для пакетов без повтора
+        quint64 rttSamples = 0;
+        qint64 minRttNs = 0;
+        qint64 maxRttNs = 0;
+        qint64 totalRttNs = 0;
+    };
+
+    static const int DEFAULT_ACK_TIMEOUT = 200;
+    static const int DEFAULT_MAX_RETRIES = 3;
+
+    explicit DFPlayerCommandQueue(PortDispatcher &port, QObject *parent = nullptr);
+
+    static CommandClass classOf(quint8 command);
+    static Priority priorityOf(quint8 command);
+    // Команда задаёт значение целиком: в очереди достаточно последней
+    static bool isCoalesced(quint8 command);
+
+    // Пауза после пакета данного класса, мс
+    void setDelay(CommandClass commandClass, int milliseconds);
+    int delay(CommandClass commandClass) const;
+
+    // Время передачи пакета по линии (по скорости порта), 0 - не учитывается
+    void setFrameTime(qint64 nanoseconds);
+    static qint64 frameTimeOf(const SettingsDialog::Settings &settings);
+
+    // frame - полный пакет, команда берётся из его 4-го байта; пакет другой длины отбрасывается
+    void enqueue(const QByteArray &frame);
+    // Пакет уходит раньше всех ожидающих (следующий трек плейлиста), без замены одноимённых
+    void enqueueFirst(const QByteArray &frame);
+    void clear();
+
+    int pending() const;
+    // 16-битный параметр ещё не отправленного пакета с этим кодом, -1 - такого нет
+    int pendingParameter(quint8 command) const;
+
+    // Режим подтверждения; window - сколько команд может ждать подтверждения одновременно
+    void setReliable(bool reliable);
+    bool isReliable() const;
+    void setWindow(int frames);
+    void setAckTimeout(int milliseconds);
+    void setMaxRetries(int retries);
+
+    // Подтверждение 0x41 от модуля
+    void handleAck();
+    // Ошибка от модуля: true, если она означает искажённый пакет и вызвала повтор
+    bool handleError(quint16 code);
+
+    const Statistics &statistics() const;
+
+    // Отправлять можно: порт свободен и пауза выдержана
+    bool isReady() const;
+
+signals:
+    // Пакет записан в порт
+    void frameSent(const QByteArray &frame);
+    // Очередь опустела и пауза после последнего пакета выдержана
+    void idle();
+    // Режим подтверждения; rttNs - время до подтверждения, -1 для повторённого пакета
+    void frameAcknowledged(const QByteArray &frame, qint64 rttNs);
+    void frameRetransmitted(const QByteArray &frame, int attempt);
+    void frameFailed(const QByteArray &frame);
+    void statisticsChanged();
+
+private:
+    struct Unacknowledged
+    {
+        QByteArray frame;
+        qint64 sentAt;
+        qint64 deadline;
+        int attempts;
+    };
+
+    void sendNext();
+    void write(const QByteArray &frame);
+    void startPause();
+    void handleBytesWritten();
+    void retransmitAll();
+    void scheduleAckTimeout();
+
+    PortDispatcher &_port;
+    std::deque<QByteArray> _frames[PriorityCount];
+    QTimer _pause;
+    int _delays[CommandClassCount];
+    qint64 _frameTimeNs = 0;
+    // Когда последний пакет записан в порт
+    qint64 _sentAt = 0;
+
+    // Пакет записан, ждём его передачи
+    bool _draining = false;
+    // Класс последнего отправленного пакета
+    CommandClass _lastClass = Control;
+
+    bool _reliable = false;
+    int _window = 1;
+    int _ackTimeout = DEFAULT_ACK_TIMEOUT;
+    int _maxRetries = DEFAULT_MAX_RETRIES;
+    // Ждут подтверждения в порядке отправки
+    std::deque<Unacknowledged> _unacknowledged;
+    // Уходят раньше очередей приоритетов
+    std::deque<Unacknowledged> _retransmit;
+    QTimer _ackTimer;
+    Statistics _statistics;
+};
+
+#endif // DFPLAYERCOMMANDQUEUE_H
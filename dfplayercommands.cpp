@@ -0,0 +1,74 @@
+#include "dfplayercommands.h"
+
+namespace DFPlayerCommands
+{
+
+QByteArray encode(Command command, quint16 first, quint16 second)
+{
+    if (TABLE[command].layout == Layout::Fixed)
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(FIXED_FRAMES[command].data()), BUFFER_SIZE);
+
+    if (!isValid(command, first, second))
+        return QByteArray();
+
+    const Frame frame = buildFrame(command, first, second);
+    return QByteArray(reinterpret_cast<const char *>(frame.data()), BUFFER_SIZE);
+}
+
+QByteArray withFeedback(const QByteArray &frame)
+{
+    if (frame.size() != BUFFER_SIZE)
+        return frame;
+
+    const quint16 param = static_cast<quint16>((static_cast<quint8>(frame[PARAM_MSB]) << 8) | static_cast<quint8>(frame[PARAM_LSB]));
+    const Frame result = buildFrame(static_cast<quint8>(frame[CMD_VALUE]), param, FEEDBACK);
+    return QByteArray(reinterpret_cast<const char *>(result.data()), BUFFER_SIZE);
+}
+
+bool sameCommand(const QByteArray &first, const QByteArray &second)
+{
+    return first.size() == BUFFER_SIZE && second.size() == BUFFER_SIZE
+            && first[CMD_VALUE] == second[CMD_VALUE]
+            && first[PARAM_MSB] == second[PARAM_MSB] && first[PARAM_LSB] == second[PARAM_LSB];
+}
+
+const Descriptor *find(quint8 opcode, quint16 param)
+{
+    const Descriptor *found = nullptr;
+    for (const Descriptor &descriptor : TABLE)
+    {
+        if (descriptor.opcode != opcode)
+            continue;
+        if (descriptor.layout != Layout::Fixed || parameter(descriptor.command) == param)
+            return &descriptor;
+        if (!found)
+            found = &descriptor;
+    }
+    return found;
+}
+
+QString describe(quint8 opcode, quint16 param)
+{
+    const Descriptor *descriptor = find(opcode, param);
+    if (!descriptor)
+        return QString();
+
+    QString text = QString::fromLatin1(descriptor->text);
+    switch (descriptor->layout)
+    {
+    case Layout::Fixed:
+        break;
+    case Layout::Word:
+        text = text.arg(param);
+        break;
+    case Layout::Pair:
+        text = text.arg(param >> 8).arg(param & 0xFF);
+        break;
+    case Layout::Folder3000:
+        text = text.arg(param >> 12).arg(param & 0x0FFF);
+        break;
+    }
+    return text;
+}
+
+}
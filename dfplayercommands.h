@@ -0,0 +1,305 @@
+#ifndef DFPLAYERCOMMANDS_H
+#define DFPLAYERCOMMANDS_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <array>
+
+/* Packet Values */
+#define BUFFER_SIZE             10   // total number of bytes in a stack/packet (same for cmds and queries)
+#define SB                      0x7E // start byte
+#define VER                     0xFF // version
+#define LEN                     0x06 // number of bytes after "LEN" (except for checksum data and EB)
+#define FEEDBACK                1    // feedback requested
+#define NO_FEEDBACK             0    // no feedback requested
+#define EB                      0xEF // end byte
+
+/* Control Commands */
+#define CTRL_NEXT               0x01
+#define CTRL_PREV               0x02
+#define CTRL_SPEC_PLAY          0x03 // Specify playback of a track(in the root directory of a storage device)
+#define CTRL_INC_VOL            0x04
+#define CTRL_DEC_VOL            0x05
+#define CTRL_VOLUME             0x06
+#define CTRL_EQ                 0x07
+#define CTRL_PLAYBACK_MODE      0x08 // Specify single repeat playback
+#define CTRL_PLAYBACK_SRC       0x09 // Specify playback of a device(USB/SD)
+#define CTRL_SLEEP              0x0A
+#define CTRL_RESET              0x0C
+#define CTRL_PLAY               0x0D
+#define CTRL_PAUSE              0x0E
+#define CTRL_SPEC_FOLDER        0x0F // Specify playback a track in a folder
+#define CTRL_AUDIO_AMPL         0x10 // Audio amplification setting
+#define CTRL_REPEAT_PLAY        0x11 // Set all repeat playback
+#define CTRL_SPEC_PLAY_MP3      0x12 // Specify playback of folder named “MP3”
+#define CTRL_INSERT_ADVERT      0x13 // Insert an advertisement
+#define CTRL_SPEC_TRACK_3000    0x14 // Specify playback a track in a folder that supports 3000 tracks
+#define CTRL_STOP_ADVERT        0x15
+#define CTRL_STOP               0x16
+#define CTRL_REPEAT_FOLDER      0x17 // Specify repeat playback of a folder
+#define CTRL_RANDOM_ALL         0x18
+#define CTRL_REPEAT_CURRENT     0x19
+#define CTRL_SET_DAC            0x1A
+
+/* Query Command */
+#define CMD_CUR_DEV_ONLINE      0x3F // Query current online storage device
+#define CMD_ERROR               0x40 // Module returns an error data with this command
+#define CMD_FEEDBACK            0x41 // Module reports a feedback with this command
+#define CMD_STATUS              0x42 // Query current status
+#define CMD_VOLUME              0x43 // Query current volume
+#define CMD_EQ                  0x44 // Query current EQ
+#define CMD_USB_FILES           0x47 // Query number of tracks in the root of USB flash drive
+#define CMD_SD_FILES            0x48 // Query number of tracks in the root of micro SD card
+#define CMD_USB_TRACK           0x4B // Query current track in the USB flash drive
+#define CMD_SD_TRACK            0x4C // Query current track in the micro SD Card
+#define CMD_FOLDER_FILES        0x4E // Query number of tracks in a folder
+#define CMD_FOLDERS             0x4F // Query number of folders in the current storage device
+
+#define CMD_DEV_PLUGGED         0x3A // storage device is plugged
+#define CMD_DEV_PULL_OUT        0x3B // storage device is pull out
+#define CMD_TRACK_FINSH_USB     0x3C // track is finished playing in USB flash drive
+#define CMD_TRACK_FINSH_SD      0x3D // track is finished playing in USB flash drive
+
+/* EQ Values */
+#define EQ_NORMAL               0
+#define EQ_POP                  1
+#define EQ_ROCK                 2
+#define EQ_JAZZ                 3
+#define EQ_CLASSIC              4
+#define EQ_BASE                 5
+
+/* Specify playback of a device */
+#define SRC_USB                 1
+#define SRC_SD                  2
+
+#define START_BYTE      0
+#define VERSION         1
+#define LENGTH          2
+#define CMD_VALUE       3
+#define FEEDBAC_VALUE   4
+#define PARAM_MSB       5
+#define PARAM_LSB       6
+#define CHECKSUM_MSB    7
+#define CHECKSUM_LSB    8
+#define END_BYTE        9
+
+// Таблица команд DFPlayer: код, раскладка параметра, допустимые значения, ожидаемый ответ и имя.
+// По ней проверяются параметры, строятся пакеты, подписываются журнал и декодер.
+// Пакеты команд без параметра собраны при компиляции, остальные строятся на стеке вызывающего.
+namespace DFPlayerCommands
+{
+
+enum Command : quint8
+{
+    Next,
+    Previous,
+    PlayTrack,
+    PlayMp3Track,
+    PlayAdvertisement,
+    StopAdvertisement,
+    VolumeUp,
+    VolumeDown,
+    Volume,
+    Equalizer,
+    Loop,
+    PlaybackSource,
+    Sleep,
+    Reset,
+    Play,
+    Pause,
+    PlayFolder,
+    PlayLargeFolder,
+    AudioAmplifier,
+    RepeatAllOn,
+    RepeatAllOff,
+    Stop,
+    RepeatFolder,
+    RandomAll,
+    RepeatCurrentOn,
+    RepeatCurrentOff,
+    DacOn,
+    DacOff,
+
+    QueryStatus,
+    QueryVolume,
+    QueryEqualizer,
+    QueryUsbFiles,
+    QuerySdFiles,
+    QueryUsbTrack,
+    QuerySdTrack,
+    QueryFolderFiles,
+    QueryFolders,
+
+    COMMAND_COUNT
+};
+
+enum class Layout : quint8
+{
+    Fixed,      // параметр задан в таблице: MSB = first.min, LSB = second.min
+    Word,       // first - 16-битный параметр
+    Pair,       // first - MSB, second - LSB
+    Folder3000  // first - папка (старшие 4 бита), second - трек (младшие 12 бит)
+};
+
+struct Range
+{
+    quint16 min;
+    quint16 max;
+};
+
+struct Descriptor
+{
+    Command command;
+    quint8 opcode;
+    Layout layout;
+    Range first;
+    Range second;
+    quint8 reply;       // код ожидаемого ответа, 0 - ответа нет
+    const char *name;
+    const char *text;   // для журнала и декодера, %1 и %2 - параметры
+};
+
+using Frame = std::array<uchar, BUFFER_SIZE>;
+
+constexpr Range NONE = {0, 0};
+constexpr Range ONE = {1, 1};
+constexpr Range ANY = {0, 0xFFFF};
+
+inline constexpr Descriptor TABLE[COMMAND_COUNT] =
+{
+    {Next,              CTRL_NEXT,            Layout::Fixed,      NONE,        ONE,         0, "next",              "Next"},
+    {Previous,          CTRL_PREV,            Layout::Fixed,      NONE,        ONE,         0, "previous",          "Previous"},
+    {PlayTrack,         CTRL_SPEC_PLAY,       Layout::Word,       {1, 3000},   NONE,        0, "playTrack",         "Play track %1"},
+    {PlayMp3Track,      CTRL_SPEC_PLAY_MP3,   Layout::Word,       {1, 9999},   NONE,        0, "playMp3Track",      "Play MP3 folder track %1"},
+    {PlayAdvertisement, CTRL_INSERT_ADVERT,   Layout::Word,       {1, 9999},   NONE,        0, "playAdvertisement", "Advertisement %1"},
+    {StopAdvertisement, CTRL_STOP_ADVERT,     Layout::Fixed,      NONE,        NONE,        0, "stopAdvertisement", "Stop advertisement"},
+    {VolumeUp,          CTRL_INC_VOL,         Layout::Fixed,      NONE,        ONE,         0, "volumeUp",          "Volume up"},
+    {VolumeDown,        CTRL_DEC_VOL,         Layout::Fixed,      NONE,        ONE,         0, "volumeDown",        "Volume down"},
+    {Volume,            CTRL_VOLUME,          Layout::Word,       {0, 30},     NONE,        0, "volume",            "Set volume %1"},
+    {Equalizer,         CTRL_EQ,              Layout::Word,       {EQ_NORMAL, EQ_BASE}, NONE, 0, "equalizer",       "Set EQ %1"},
+    {Loop,              CTRL_PLAYBACK_MODE,   Layout::Word,       {1, 3000},   NONE,        0, "loop",              "Loop track %1"},
+    {PlaybackSource,    CTRL_PLAYBACK_SRC,    Layout::Word,       {SRC_USB, SRC_SD}, NONE,  0, "playbackSource",    "Playback source %1"},
+    {Sleep,             CTRL_SLEEP,           Layout::Fixed,      NONE,        NONE,        0, "sleep",             "Sleep"},
+    {Reset,             CTRL_RESET,           Layout::Fixed,      NONE,        ONE,         0, "reset",             "Reset"},
+    {Play,              CTRL_PLAY,            Layout::Fixed,      NONE,        NONE,        0, "play",              "Play"},
+    {Pause,             CTRL_PAUSE,           Layout::Fixed,      NONE,        ONE,         0, "pause",             "Pause"},
+    {PlayFolder,        CTRL_SPEC_FOLDER,     Layout::Pair,       {1, 99},     {1, 255},    0, "playFolder",        "Play folder %1 track %2"},
+    {PlayLargeFolder,   CTRL_SPEC_TRACK_3000, Layout::Folder3000, {1, 15},     {1, 3000},   0, "playLargeFolder",   "Play folder %1 track %2"},
+    {AudioAmplifier,    CTRL_AUDIO_AMPL,      Layout::Pair,       {0, 1},      {0, 31},     0, "audioAmplifier",    "Volume adjust %1 gain %2"},
+    {RepeatAllOn,       CTRL_REPEAT_PLAY,     Layout::Fixed,      NONE,        ONE,         0, "repeatAllOn",       "Repeat all on"},
+    {RepeatAllOff,      CTRL_REPEAT_PLAY,     Layout::Fixed,      NONE,        NONE,        0, "repeatAllOff",      "Repeat all off"},
+    {Stop,              CTRL_STOP,            Layout::Fixed,      NONE,        NONE,        0, "stop",              "Stop"},
+    {RepeatFolder,      CTRL_REPEAT_FOLDER,   Layout::Word,       {1, 99},     NONE,        0, "repeatFolder",      "Repeat folder %1"},
+    {RandomAll,         CTRL_RANDOM_ALL,      Layout::Fixed,      NONE,        NONE,        0, "randomAll",         "Random all"},
+    {RepeatCurrentOn,   CTRL_REPEAT_CURRENT,  Layout::Fixed,      NONE,        NONE,        0, "repeatCurrentOn",   "Repeat current on"},
+    {RepeatCurrentOff,  CTRL_REPEAT_CURRENT,  Layout::Fixed,      NONE,        ONE,         0, "repeatCurrentOff",  "Repeat current off"},
+    {DacOn,             CTRL_SET_DAC,         Layout::Fixed,      NONE,        NONE,        0, "dacOn",             "DAC on"},
+    {DacOff,            CTRL_SET_DAC,         Layout::Fixed,      NONE,        ONE,         0, "dacOff",            "DAC off"},
+
+    {QueryStatus,       CMD_STATUS,           Layout::Fixed,      NONE,        NONE, CMD_STATUS,       "queryStatus",      "Query status"},
+    {QueryVolume,       CMD_VOLUME,           Layout::Fixed,      NONE,        NONE, CMD_VOLUME,       "queryVolume",      "Query volume"},
+    {QueryEqualizer,    CMD_EQ,               Layout::Fixed,      NONE,        NONE, CMD_EQ,           "queryEqualizer",   "Query EQ"},
+    {QueryUsbFiles,     CMD_USB_FILES,        Layout::Fixed,      NONE,        NONE, CMD_USB_FILES,    "queryUsbFiles",    "Query files in USB"},
+    {QuerySdFiles,      CMD_SD_FILES,         Layout::Fixed,      NONE,        NONE, CMD_SD_FILES,     "querySdFiles",     "Query files in SD"},
+    {QueryUsbTrack,     CMD_USB_TRACK,        Layout::Fixed,      NONE,        NONE, CMD_USB_TRACK,    "queryUsbTrack",    "Query current USB track"},
+    {QuerySdTrack,      CMD_SD_TRACK,         Layout::Fixed,      NONE,        NONE, CMD_SD_TRACK,     "querySdTrack",     "Query current SD track"},
+    {QueryFolderFiles,  CMD_FOLDER_FILES,     Layout::Word,       {1, 99},     NONE, CMD_FOLDER_FILES, "queryFolderFiles", "Query tracks in folder %1"},
+    {QueryFolders,      CMD_FOLDERS,          Layout::Fixed,      NONE,        NONE, CMD_FOLDERS,      "queryFolders",     "Query folders"},
+};
+
+constexpr bool tableInOrder()
+{
+    for (int i = 0; i < COMMAND_COUNT; ++i)
+    {
+        if (TABLE[i].command != i)
+            return false;
+    }
+    return true;
+}
+static_assert(tableInOrder(), "DFPlayerCommands::TABLE must be ordered by Command");
+
+constexpr bool inRange(Range range, quint16 value)
+{
+    return value >= range.min && value <= range.max;
+}
+
+constexpr bool isValid(Command command, quint16 first = 0, quint16 second = 0)
+{
+    const Descriptor &descriptor = TABLE[command];
+    switch (descriptor.layout)
+    {
+    case Layout::Fixed:
+        return true;
+    case Layout::Word:
+        return inRange(descriptor.first, first);
+    default:
+        return inRange(descriptor.first, first) && inRange(descriptor.second, second);
+    }
+}
+
+// 16-битный параметр пакета
+constexpr quint16 parameter(Command command, quint16 first = 0, quint16 second = 0)
+{
+    const Descriptor &descriptor = TABLE[command];
+    switch (descriptor.layout)
+    {
+    case Layout::Fixed:
+        return static_cast<quint16>((descriptor.first.min << 8) | descriptor.second.min);
+    case Layout::Word:
+        return first;
+    case Layout::Pair:
+        return static_cast<quint16>((first << 8) | (second & 0xFF));
+    default:
+        return static_cast<quint16>((first << 12) | (second & 0x0FFF));
+    }
+}
+
+constexpr Frame buildFrame(quint8 opcode, quint16 param, quint8 feedback = NO_FEEDBACK)
+{
+    const quint8 msb = static_cast<quint8>(param >> 8);
+    const quint8 lsb = static_cast<quint8>(param);
+    const quint16 checksum = static_cast<quint16>(-(VER + LEN + opcode + feedback + msb + lsb));
+    return Frame{{SB, VER, LEN, opcode, feedback, msb, lsb,
+                  static_cast<uchar>(checksum >> 8), static_cast<uchar>(checksum), EB}};
+}
+
+constexpr Frame buildFrame(Command command, quint16 first = 0, quint16 second = 0)
+{
+    return buildFrame(TABLE[command].opcode, parameter(command, first, second));
+}
+
+// Пакеты команд с фиксированным параметром; для остальных - пакет с нулевыми параметрами (не используется)
+constexpr std::array<Frame, COMMAND_COUNT> buildFixedFrames()
+{
+    std::array<Frame, COMMAND_COUNT> frames = {};
+    for (int i = 0; i < COMMAND_COUNT; ++i)
+        frames[i] = buildFrame(static_cast<Command>(i));
+    return frames;
+}
+
+inline constexpr std::array<Frame, COMMAND_COUNT> FIXED_FRAMES = buildFixedFrames();
+
+// Контрольная сумма по документации: 7E FF 06 01 00 00 01 FE F9 EF
+static_assert(FIXED_FRAMES[Next][CHECKSUM_MSB] == 0xFE && FIXED_FRAMES[Next][CHECKSUM_LSB] == 0xF9,
+              "DFPlayer checksum");
+
+// Пакет команды; пустой массив, если параметры вне допустимых значений.
+// Пакет без параметра ссылается на FIXED_FRAMES без копирования.
+QByteArray encode(Command command, quint16 first = 0, quint16 second = 0);
+
+// Тот же пакет с запросом подтверждения 0x41 (бит FEEDBACK и новая контрольная сумма)
+QByteArray withFeedback(const QByteArray &frame);
+
+// Тот же код и параметр (бит FEEDBACK и контрольная сумма не сравниваются)
+bool sameCommand(const QByteArray &first, const QByteArray &second);
+
+// Описание команды по коду и параметру пакета (для общих кодов выбирается по фиксированному параметру)
+const Descriptor *find(quint8 opcode, quint16 param);
+
+// Текст команды с параметрами, пустая строка для неизвестного кода
+QString describe(quint8 opcode, quint16 param);
+
+}
+
+#endif // DFPLAYERCOMMANDS_H
@@ -0,0 +1,149 @@
+#include "dfplayerdecoder.h"
+#include "dfplayercommands.h"
+
+const QString DFPlayerDecoder::NAME = QStringLiteral("DFPlayer");
+
+static QString deviceName(quint16 device)
+{
+    switch (device)
+    {
+    case 1:
+        return QStringLiteral("USB flash drive");
+    case 2:
+        return QStringLiteral("SD card");
+    case 3:
+        return QStringLiteral("PC");
+    case 4:
+        return QStringLiteral("USB flash drive and SD card");
+    default:
+        return QStringLiteral("device %1").arg(device);
+    }
+}
+
+static QString errorText(quint16 code)
+{
+    switch (code)
+    {
+    case 0x1:
+        return QStringLiteral("Module busy");
+    case 0x2:
+        return QStringLiteral("Currently sleep mode");
+    case 0x3:
+        return QStringLiteral("Serial receiving error");
+    case 0x4:
+        return QStringLiteral("Checksum incorrect");
+    case 0x5:
+        return QStringLiteral("Specified track is out of current track scope");
+    case 0x6:
+        return QStringLiteral("Specified track is not found");
+    case 0x7:
+        return QStringLiteral("Insertion error");
+    case 0x8:
+        return QStringLiteral("SD card reading failed");
+    case 0xA:
+        return QStringLiteral("Entered into sleep mode");
+    default:
+        return QStringLiteral("Unknown error: %1").arg(code);
+    }
+}
+
+QString DFPlayerDecoder::name() const
+{
+    return NAME;
+}
+
+QString DFPlayerDecoder::describe(const Packet &packet) const
+{
+    if (packet.status == ChecksumError)
+        return QStringLiteral("DFPlayer: checksum error (cmd 0x%1)").arg(packet.type, 2, 16, QChar('0'));
+    if (packet.status == FormatError)
+        return QStringLiteral("DFPlayer: malformed frame");
+
+    const quint32 value = packet.value;
+    const quint16 lsb = value & 0xFF;
+    const quint16 msb = value >> 8;
+    QString text;
+    switch (packet.type)
+    {
+    // Ответы и сообщения модуля
+    case CMD_CUR_DEV_ONLINE:
+        text = deviceName(lsb) + " online";
+        break;
+    case CMD_ERROR:
+        text = "Error: " + errorText(lsb);
+        break;
+    case CMD_FEEDBACK:
+        text = "Module has successfully received the command";
+        break;
+    case CMD_STATUS:
+        if (msb == 0x10)
+            text = "Module in sleep mode";
+        else
+            text = QString("A track in %1 is %2").arg(msb == 1 ? "USB" : "SD")
+                    .arg(lsb == 0 ? "stopped" : lsb == 1 ? "playing" : "paused");
+        break;
+    case CMD_VOLUME:
+        text = QString("Volume is %1").arg(lsb);
+        break;
+    case CMD_EQ:
+        text = QString("EQ is %1").arg(lsb);
+        break;
+    case CMD_USB_FILES:
+        text = QString("Files in USB: %1").arg(value);
+        break;
+    case CMD_SD_FILES:
+        text = QString("Files in SD: %1").arg(value);
+        break;
+    case CMD_USB_TRACK:
+        text = QString("The track %1 in USB being played").arg(value);
+        break;
+    case CMD_SD_TRACK:
+        text = QString("The track %1 in SD being played").arg(value);
+        break;
+    case CMD_FOLDER_FILES:
+        text = QString("%1 track in folder").arg(value);
+        break;
+    case CMD_FOLDERS:
+        text = QString("%1 folders in current device").arg(value);
+        break;
+    case CMD_DEV_PLUGGED:
+        text = deviceName(lsb) + " is plugged in";
+        break;
+    case CMD_DEV_PULL_OUT:
+        text = deviceName(lsb) + " is pulled out";
+        break;
+    case CMD_TRACK_FINSH_USB:
+        text = QString("%1 track is finished playing in USB flash drive").arg(value);
+        break;
+    case CMD_TRACK_FINSH_SD:
+        text = QString("%1 track is finished playing in SD card").arg(value);
+        break;
+
+    // Команды управления (видны при эхе или в записи передачи) - по таблице команд
+    default:
+        text = DFPlayerCommands::describe(packet.type, static_cast<quint16>(value));
+        if (text.isEmpty())
+            text = QString("Unknown command 0x%1, param %2").arg(packet.type, 2, 16, QChar('0')).arg(value);
+    }
+    return "DFPlayer: " + text;
+}
+
+void DFPlayerDecoder::consume(const char *data, size_t size, quint64 offset, qint64 timestamp)
+{
+    _parser.feed(data, size, offset, [this, timestamp](const DFPlayerFrameParser::Frame &frame) {
+        Packet packet;
+        packet.offset = frame.offset;
+        packet.length = frame.length;
+        packet.timestamp = timestamp;
+        packet.type = frame.command;
+        packet.value = frame.value;
+        packet.status = frame.status == DFPlayerFrameParser::Valid ? Valid
+                      : frame.status == DFPlayerFrameParser::ChecksumError ? ChecksumError : FormatError;
+        addPacket(packet);
+    });
+}
+
+void DFPlayerDecoder::clearState()
+{
+    _parser.reset();
+}
@@ -0,0 +1,25 @@
+#ifndef DFPLAYERDECODER_H
+#define DFPLAYERDECODER_H
+
+#include "dfplayerframeparser.h"
+#include "protocoldecoder.h"
+
+// Пакеты DFPlayer Mini: 7E FF 06 CMD FEEDBACK MSB LSB CHK_MSB CHK_LSB EF.
+// Разбор - DFPlayerFrameParser, состояние - не более одного незавершённого пакета.
+class DFPlayerDecoder : public ProtocolDecoder
+{
+public:
+    static const QString NAME;
+
+    virtual QString name() const override;
+    virtual QString describe(const Packet &packet) const override;
+
+protected:
+    virtual void consume(const char *data, size_t size, quint64 offset, qint64 timestamp) override;
+    virtual void clearState() override;
+
+private:
+    DFPlayerFrameParser _parser;
+};
+
+#endif // DFPLAYERDECODER_H
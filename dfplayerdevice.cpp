@@ -0,0 +1,159 @@
+#include "dfplayerdevice.h"
+#include "monotonicclock.h"
+
+DFPlayerDevice::DFPlayerDevice(QObject *parent)
+    : QObject(parent)
+    , _engine(_port, _state)
+{
+    _port.subscribe(this);
+    connect(&_port, &PortDispatcher::dataWritten, this, &DFPlayerDevice::dataWritten);
+    connect(&_engine, &DFPlayerEngine::commandSent, this, [this](quint8 opcode) {
+        if (opcode == CMD_STATUS)
+            _pollSentAt = MonotonicClock::nowNs();
+    });
+    connect(&_state, &DFPlayerState::changed, this, &DFPlayerDevice::changed);
+}
+
+DFPlayerDevice::~DFPlayerDevice()
+{
+    close();
+    _port.unsubscribe(this);
+}
+
+bool DFPlayerDevice::open(const SettingsDialog::Settings &settings, QThread *ioThread, QString &error)
+{
+    _portName = settings.name;
+    _ioThread = ioThread;
+    _port.setReaderThread(ioThread);
+    if (!_port.open(settings, true, error))
+        return false;
+
+    _engine.commands().setFrameTime(DFPlayerCommandQueue::frameTimeOf(settings));
+    _parser.reset();
+    _state.invalidateAll();
+    _health = {};
+    return true;
+}
+
+void DFPlayerDevice::close()
+{
+    if (!_port.isOpen())
+        return;
+
+    // Порт закрывается первым: отменённый опрос не считается потерей связи
+    _port.close();
+    _engine.clear();
+    _writing.clear();
+    _health.online = false;
+    emit changed();
+}
+
+bool DFPlayerDevice::isOpen() const
+{
+    return _port.isOpen();
+}
+
+QString DFPlayerDevice::portName() const
+{
+    return _portName;
+}
+
+QThread *DFPlayerDevice::ioThread() const
+{
+    return _ioThread;
+}
+
+DFPlayerCommandQueue &DFPlayerDevice::commands()
+{
+    return _engine.commands();
+}
+
+const DFPlayerState &DFPlayerDevice::state() const
+{
+    return _state;
+}
+
+const DFPlayerDevice::Health &DFPlayerDevice::health() const
+{
+    return _health;
+}
+
+const DFPlayerFrameParser::Counters &DFPlayerDevice::counters() const
+{
+    return _parser.counters();
+}
+
+bool DFPlayerDevice::send(DFPlayerCommands::Command command, quint16 first, quint16 second)
+{
+    return _port.isOpen() && _engine.send(command, first, second);
+}
+
+void DFPlayerDevice::poll()
+{
+    if (_polling || !_port.isOpen())
+        return;
+
+    _polling = true;
+    _engine.query(DFPlayerCommands::QueryStatus, 0, [this](bool ok, quint16) {
+        _polling = false;
+        if (ok)
+            _health.rttNs = MonotonicClock::nowNs() - _pollSentAt;
+        else if (_port.isOpen())
+            _health.timeouts++;
+        _health.online = ok;
+        emit changed();
+    });
+
+    // Для таблицы парка - только устаревшие поля, ответы разбирает DFPlayerState
+    for (DFPlayerState::Field field : {DFPlayerState::Volume, DFPlayerState::SdTrack})
+    {
+        if (!_state.isValid(field))
+            send(DFPlayerState::queryOf(field));
+    }
+}
+
+void DFPlayerDevice::portReceived(const QByteArray &data, qint64 timestamp)
+{
+    Q_UNUSED(timestamp);
+
+    _parser.feed(data.constData(), static_cast<size_t>(data.size()), _received,
+                 [this](const DFPlayerFrameParser::Frame &frame) { handleFrame(frame); });
+    _received += static_cast<quint64>(data.size());
+}
+
+void DFPlayerDevice::portSent(const QByteArray &data, qint64 timestamp)
+{
+    Q_UNUSED(timestamp);
+
+    _writing.push_back(data);
+}
+
+void DFPlayerDevice::handleFrame(const DFPlayerFrameParser::Frame &frame)
+{
+    if (frame.status != DFPlayerFrameParser::Valid)
+    {
+        emit changed();
+        return;
+    }
+
+    _health.replies++;
+    _health.lastReplyAt = MonotonicClock::nowNs();
+    if (_engine.updateState(frame.command, frame.value))
+    {
+        if (frame.command == CMD_ERROR)
+            _health.errors++;
+        _engine.dispatch(frame.command, frame.value);
+    }
+    emit changed();
+}
+
+void DFPlayerDevice::dataWritten(qint64 timestamp)
+{
+    // Порт пишет порции по порядку - сообщение о записи относится к самой старой
+    if (_writing.empty())
+        return;
+
+    const QByteArray frame = _writing.front();
+    _writing.pop_front();
+    emit frameWritten(frame, timestamp);
+}
@@ -0,0 +1,84 @@
+#ifndef DFPLAYERDEVICE_H
+#define DFPLAYERDEVICE_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QThread>
+
+#include <deque>
+
+#include "dfplayercommandqueue.h"
+#include "dfplayercommands.h"
+#include "dfplayerengine.h"
+#include "dfplayerframeparser.h"
+#include "dfplayerstate.h"
+#include "portdispatcher.h"
+
+// Один модуль парка DFPlayer: свой порт, разбор пакетов, кэш состояния и обмен DFPlayerEngine -
+// тот же, что у панели DF_Player, но без окна.
+// Порт читается и пишется в потоке общего пула ввода-вывода, логика модуля работает в потоке GUI.
+class DFPlayerDevice : public QObject, public PortSubscriber
+{
+    Q_OBJECT
+
+public:
+    struct Health
+    {
+        bool online = false;        // последний опрос получил ответ
+        quint64 replies = 0;
+        quint64 timeouts = 0;       // опрос без ответа
+        quint64 errors = 0;         // CMD_ERROR от модуля
+        qint64 lastReplyAt = 0;     // 0 - ответов не было
+        qint64 rttNs = -1;          // время ответа на последний опрос
+    };
+
+    explicit DFPlayerDevice(QObject *parent = nullptr);
+    ~DFPlayerDevice();
+
+    bool open(const SettingsDialog::Settings &settings, QThread *ioThread, QString &error);
+    void close();
+    bool isOpen() const;
+    QString portName() const;
+    QThread *ioThread() const;
+
+    DFPlayerCommandQueue &commands();
+    const DFPlayerState &state() const;
+    const Health &health() const;
+    const DFPlayerFrameParser::Counters &counters() const;
+
+    bool send(DFPlayerCommands::Command command, quint16 first = 0, quint16 second = 0);
+    // Запрос состояния - он же проверка связи; следующий не ставится, пока ждёт предыдущий.
+    // Заодно запрашиваются устаревшие громкость и трек
+    void poll();
+
+    // PortSubscriber interface
+    virtual void portReceived(const QByteArray &data, qint64 timestamp) override;
+    virtual void portSent(const QByteArray &data, qint64 timestamp) override;
+
+signals:
+    void changed();
+    // Пакет передан порту; timestamp снят потоком ввода-вывода
+    void frameWritten(const QByteArray &frame, qint64 timestamp);
+
+private:
+    void handleFrame(const DFPlayerFrameParser::Frame &frame);
+    void dataWritten(qint64 timestamp);
+
+    PortDispatcher _port;
+    // Кэш состояния создаётся раньше обмена, который его обновляет
+    DFPlayerState _state;
+    DFPlayerEngine _engine;
+    DFPlayerFrameParser _parser;
+    quint64 _received = 0;
+    Health _health;
+    // Имя сохраняется и для порта, который не открылся
+    QString _portName;
+    QThread *_ioThread = nullptr;
+
+    bool _polling = false;
+    qint64 _pollSentAt = 0;
+    // Отправленные пакеты, для которых поток ввода-вывода ещё не сообщил о записи
+    std::deque<QByteArray> _writing;
+};
+
+#endif // DFPLAYERDEVICE_H
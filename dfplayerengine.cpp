@@ -0,0 +1,85 @@
+#include "dfplayerengine.h"
+
+DFPlayerEngine::DFPlayerEngine(PortDispatcher &port, DFPlayerState &state, QObject *parent)
+    : QObject(parent),
+      _commands(port),
+      _state(state)
+{
+    connect(&_commands, &DFPlayerCommandQueue::frameSent, this, &DFPlayerEngine::frameSent);
+}
+
+DFPlayerCommandQueue &DFPlayerEngine::commands()
+{
+    return _commands;
+}
+
+DFPlayerQueries &DFPlayerEngine::queries()
+{
+    return _queries;
+}
+
+bool DFPlayerEngine::send(DFPlayerCommands::Command command, quint16 first, quint16 second)
+{
+    const QByteArray frame = DFPlayerCommands::encode(command, first, second);
+    if (frame.isEmpty())
+    {
+        emit commandRejected(command, first, second);
+        return false;
+    }
+
+    _commands.enqueue(frame);
+    return true;
+}
+
+bool DFPlayerEngine::query(DFPlayerCommands::Command command, quint16 param, DFPlayerQueries::Callback callback,
+                           int timeout)
+{
+    const QByteArray frame = DFPlayerCommands::encode(command, param);
+    if (frame.isEmpty())
+    {
+        emit commandRejected(command, param, 0);
+        return false;
+    }
+
+    _queries.enqueue(_commands, frame, std::move(callback), timeout);
+    return true;
+}
+
+bool DFPlayerEngine::updateState(quint8 command, quint16 value)
+{
+    if (_state.isRepeatedFinish(command, value))
+        return false;
+
+    _state.messageReceived(command, value);
+    return true;
+}
+
+void DFPlayerEngine::dispatch(quint8 command, quint16 value)
+{
+    // Искажённую команду повторяет очередь, иначе ошибка относится к запросу
+    if (command == CMD_ERROR)
+    {
+        if (!_commands.handleError(value))
+            _queries.handleError(value);
+    }
+    else if (command == CMD_FEEDBACK)
+        _commands.handleAck();
+    else
+        _queries.handleReply(command, value);
+}
+
+void DFPlayerEngine::clear()
+{
+    _commands.clear();
+    _queries.cancelAll();
+}
+
+void DFPlayerEngine::frameSent(const QByteArray &frame)
+{
+    const quint8 opcode = static_cast<quint8>(frame[CMD_VALUE]);
+    const quint16 param = static_cast<quint16>((static_cast<quint8>(frame[PARAM_MSB]) << 8)
+                                               | static_cast<quint8>(frame[PARAM_LSB]));
+    _queries.markSent(opcode);
+    _state.commandSent(opcode, param);
+    emit commandSent(opcode, param);
+}
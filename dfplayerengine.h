@@ -0,0 +1,52 @@
+#ifndef DFPLAYERENGINE_H
+#define DFPLAYERENGINE_H
+
+#include <QObject>
+
+#include "dfplayercommandqueue.h"
+#include "dfplayercommands.h"
+#include "dfplayerqueries.h"
+#include "dfplayerstate.h"
+#include "portdispatcher.h"
+
+// Обмен с одним модулем DFPlayer - общий для панели DF_Player и модуля парка DFPlayerDevice.
+// Записанные команды и принятые пакеты обновляют кэш состояния; принятый пакет затем достаётся
+// очереди (подтверждение 0x41, ошибка приёма 0x3/0x4 - повтор) или ожидающему запросу.
+class DFPlayerEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    DFPlayerEngine(PortDispatcher &port, DFPlayerState &state, QObject *parent = nullptr);
+
+    DFPlayerCommandQueue &commands();
+    DFPlayerQueries &queries();
+
+    // false - параметры вне диапазона, команда не поставлена
+    bool send(DFPlayerCommands::Command command, quint16 first = 0, quint16 second = 0);
+    bool query(DFPlayerCommands::Command command, quint16 param, DFPlayerQueries::Callback callback,
+               int timeout = DFPlayerQueries::DEFAULT_TIMEOUT);
+
+    // Пакет от модуля обновляет кэш состояния; false - повтор сообщения об окончании трека,
+    // дальше он не передаётся
+    bool updateState(quint8 command, quint16 value);
+    // Затем пакет передаётся очереди или ожидающему запросу
+    void dispatch(quint8 command, quint16 value);
+
+    // Порт закрыт: неотправленное не уйдёт, ожидающие запросы завершаются неудачей
+    void clear();
+
+signals:
+    // Команда записана в порт, кэш состояния уже обновлён
+    void commandSent(quint8 opcode, quint16 param);
+    void commandRejected(DFPlayerCommands::Command command, quint16 first, quint16 second);
+
+private:
+    void frameSent(const QByteArray &frame);
+
+    DFPlayerCommandQueue _commands;
+    DFPlayerQueries _queries;
+    DFPlayerState &_state;
+};
+
+#endif // DFPLAYERENGINE_H
@@ -0,0 +1,176 @@
+#include "dfplayerfleet.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+
+DFPlayerFleet::DFPlayerFleet(QObject *parent)
+    : QObject(parent)
+{
+    connect(&_pollTimer, &QTimer::timeout, this, &DFPlayerFleet::poll);
+    // Готовность очередей проверяется каждую миллисекунду, пока команда ждёт
+    _broadcastTimer.setTimerType(Qt::PreciseTimer);
+    _broadcastTimer.setSingleShot(true);
+    connect(&_broadcastTimer, &QTimer::timeout, this, &DFPlayerFleet::sendBroadcast);
+}
+
+DFPlayerFleet::~DFPlayerFleet()
+{
+    close();
+}
+
+void DFPlayerFleet::open(const QStringList &ports, const SettingsDialog::Settings &settings)
+{
+    close();
+
+    for (const QString &port : ports)
+    {
+        const int index = static_cast<int>(_devices.size());
+        _devices.emplace_back(new DFPlayerDevice);
+        DFPlayerDevice *device = _devices.back().get();
+        connect(device, &DFPlayerDevice::changed, this, [this, index]() { emit deviceChanged(index); });
+        connect(device, &DFPlayerDevice::frameWritten, this, [this, index](const QByteArray &frame, qint64 timestamp) {
+            frameWritten(index, frame, timestamp);
+        });
+
+        SettingsDialog::Settings deviceSettings = settings;
+        deviceSettings.name = port;
+        QString error;
+        QThread *thread = _pool.acquire();
+        if (!device->open(deviceSettings, thread, error))
+            _pool.release(thread);
+        _errors.append(error);
+    }
+
+    poll();
+    _pollTimer.start(POLL_INTERVAL);
+}
+
+void DFPlayerFleet::close()
+{
+    _pollTimer.stop();
+    _broadcastTimer.stop();
+    _broadcasts.clear();
+    _measured.clear();
+
+    for (std::unique_ptr<DFPlayerDevice> &device : _devices)
+    {
+        if (device->isOpen())
+        {
+            device->close();
+            _pool.release(device->ioThread());
+        }
+    }
+    _devices.clear();
+    _errors.clear();
+}
+
+int DFPlayerFleet::count() const
+{
+    return static_cast<int>(_devices.size());
+}
+
+DFPlayerDevice &DFPlayerFleet::device(int index)
+{
+    return *_devices[static_cast<size_t>(index)];
+}
+
+QString DFPlayerFleet::errorString(int index) const
+{
+    return _errors.value(index);
+}
+
+int DFPlayerFleet::ioThreadCount() const
+{
+    return _pool.threadCount();
+}
+
+bool DFPlayerFleet::broadcast(DFPlayerCommands::Command command, quint16 first, quint16 second)
+{
+    const QByteArray frame = DFPlayerCommands::encode(command, first, second);
+    if (frame.isEmpty())
+        return false;
+
+    // Команды воспроизведения не теряются: Stop, за которым сразу нажата громкость, уйдёт первым
+    const quint8 opcode = static_cast<quint8>(frame[CMD_VALUE]);
+    if (DFPlayerCommandQueue::isCoalesced(opcode))
+    {
+        auto it = std::find_if(_broadcasts.begin(), _broadcasts.end(),
+                               [opcode](const QByteArray &pending) { return static_cast<quint8>(pending[CMD_VALUE]) == opcode; });
+        if (it != _broadcasts.end())
+        {
+            *it = frame;
+            return true;
+        }
+    }
+
+    _broadcasts.push_back(frame);
+    if (_broadcasts.size() == 1)
+    {
+        _broadcastDeadline = MonotonicClock::nowNs() + BROADCAST_WAIT * MonotonicClock::NS_PER_MS;
+        sendBroadcast();
+    }
+    return true;
+}
+
+void DFPlayerFleet::poll()
+{
+    for (std::unique_ptr<DFPlayerDevice> &device : _devices)
+        device->poll();
+}
+
+void DFPlayerFleet::sendBroadcast()
+{
+    if (_broadcasts.empty())
+        return;
+
+    const bool ready = std::all_of(_devices.begin(), _devices.end(), [](const std::unique_ptr<DFPlayerDevice> &device) {
+        return !device->isOpen() || device->commands().isReady();
+    });
+    if (!ready && MonotonicClock::nowNs() < _broadcastDeadline)
+    {
+        _broadcastTimer.start(1);
+        return;
+    }
+
+    _measured = _broadcasts.front();
+    _broadcasts.pop_front();
+    _writtenAt.assign(_devices.size(), 0);
+    _unwritten = 0;
+    // Запись в порты уходит потокам пула подряд, без промежуточной работы
+    for (std::unique_ptr<DFPlayerDevice> &device : _devices)
+    {
+        if (device->isOpen())
+        {
+            _unwritten++;
+            device->commands().enqueueFirst(_measured);
+        }
+    }
+
+    // Следующая ждёт, пока очереди выдержат паузу после этой
+    if (!_broadcasts.empty())
+    {
+        _broadcastDeadline = MonotonicClock::nowNs() + BROADCAST_WAIT * MonotonicClock::NS_PER_MS;
+        _broadcastTimer.start(1);
+    }
+}
+
+void DFPlayerFleet::frameWritten(int index, const QByteArray &frame, qint64 timestamp)
+{
+    if (_unwritten == 0 || !DFPlayerCommands::sameCommand(frame, _measured) || _writtenAt[static_cast<size_t>(index)] != 0)
+        return;
+
+    _writtenAt[static_cast<size_t>(index)] = timestamp;
+    if (--_unwritten > 0)
+        return;
+
+    qint64 first = 0;
+    qint64 last = 0;
+    for (qint64 writtenAt : _writtenAt)
+    {
+        if (writtenAt == 0)
+            continue;
+        first = first ? qMin(first, writtenAt) : writtenAt;
+        last = qMax(last, writtenAt);
+    }
+    emit broadcastCompleted(last - first);
+}
@@ -0,0 +1,71 @@
+#ifndef DFPLAYERFLEET_H
+#define DFPLAYERFLEET_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "dfplayerdevice.h"
+#include "serialiopool.h"
+
+// Парк модулей DFPlayer, каждый на своём порту. Порты обслуживает общий пул потоков ввода-вывода,
+// у каждого модуля своя очередь команд и кэш состояния; раз в POLL_INTERVAL запрашивается состояние.
+// Широковещательная команда кодируется один раз и ставится всем очередям подряд, когда все они
+// готовы писать без паузы: иначе пауза одного модуля после предыдущей команды разнесла бы запуск
+// на десятки миллисекунд. Разброс моментов записи в порты измеряется потоками ввода-вывода.
+class DFPlayerFleet : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int POLL_INTERVAL = 1000;
+    // Дольше очереди не ждут - команда уходит тем, кто готов, остальным по готовности.
+    // Ждущие команды уходят по порядку; новое значение настройки (громкость...) заменяет ждущее
+    static const int BROADCAST_WAIT = 200;
+
+    explicit DFPlayerFleet(QObject *parent = nullptr);
+    ~DFPlayerFleet();
+
+    // Порты открываются с общими параметрами, меняется только имя; ошибки - по устройствам
+    void open(const QStringList &ports, const SettingsDialog::Settings &settings);
+    void close();
+
+    int count() const;
+    DFPlayerDevice &device(int index);
+    QString errorString(int index) const;
+    int ioThreadCount() const;
+
+    bool broadcast(DFPlayerCommands::Command command, quint16 first = 0, quint16 second = 0);
+
+signals:
+    void deviceChanged(int index);
+    // skewNs - разброс записи команды в порты всех устройств
+    void broadcastCompleted(qint64 skewNs);
+
+private:
+    void poll();
+    void sendBroadcast();
+    void frameWritten(int index, const QByteArray &frame, qint64 timestamp);
+
+    SerialIoPool _pool;
+    std::vector<std::unique_ptr<DFPlayerDevice>> _devices;
+    QStringList _errors;
+    QTimer _pollTimer;
+
+    // Команды, ждущие готовности очередей; срок ожидания - у первой
+    std::deque<QByteArray> _broadcasts;
+    qint64 _broadcastDeadline = 0;
+    QTimer _broadcastTimer;
+
+    // Замер разброса последней отправленной команды
+    QByteArray _measured;
+    std::vector<qint64> _writtenAt;
+    int _unwritten = 0;
+};
+
+#endif // DFPLAYERFLEET_H
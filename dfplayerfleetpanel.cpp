@@ -0,0 +1,163 @@
+#include "dfplayerfleetpanel.h"
+#include "ui_dfplayerfleetpanel.h"
+
+#include <QSerialPortInfo>
+
+#include "monotonicclock.h"
+
+namespace
+{
+enum Column
+{
+    PortColumn,
+    LinkColumn,
+    StatusColumn,
+    VolumeColumn,
+    TrackColumn,
+    RttColumn,
+    RepliesColumn,
+    TimeoutsColumn,
+    ErrorsColumn,
+    CorruptColumn,
+    COLUMN_COUNT
+};
+
+// Модуль молчит дольше - связь считается потерянной, даже если опрос ещё ждёт
+const qint64 SILENCE_NS = 3LL * DFPlayerFleet::POLL_INTERVAL * MonotonicClock::NS_PER_MS;
+}
+
+DFPlayerFleetPanel::DFPlayerFleetPanel(const SettingsDialog &settings, QWidget *parent) :
+    QWidget(parent),
+    _settings(settings),
+    ui(new Ui::DFPlayerFleetPanel)
+{
+    ui->setupUi(this);
+
+    // По умолчанию - все порты системы; порт терминала пользователь убирает сам
+    QStringList ports;
+    for (const QSerialPortInfo &info : QSerialPortInfo::availablePorts())
+        ports.append(info.portName());
+    ui->ports->setText(ports.join(QStringLiteral(", ")));
+
+    connect(&_fleet, &DFPlayerFleet::deviceChanged, this, &DFPlayerFleetPanel::showDevice);
+    connect(&_fleet, &DFPlayerFleet::broadcastCompleted, this, &DFPlayerFleetPanel::showSkew);
+}
+
+DFPlayerFleetPanel::~DFPlayerFleetPanel()
+{
+    _fleet.close();
+
+    delete ui;
+}
+
+void DFPlayerFleetPanel::showDevices()
+{
+    ui->devices->setRowCount(_fleet.count());
+    int opened = 0;
+    for (int index = 0; index < _fleet.count(); ++index)
+    {
+        for (int column = 0; column < COLUMN_COUNT; ++column)
+        {
+            if (!ui->devices->item(index, column))
+                ui->devices->setItem(index, column, new QTableWidgetItem);
+        }
+        if (_fleet.device(index).isOpen())
+            opened++;
+        showDevice(index);
+    }
+    ui->fleetStatus->setText(_fleet.count() ? tr("открыто %1 из %2, потоков ввода-вывода %3")
+                                              .arg(opened).arg(_fleet.count()).arg(_fleet.ioThreadCount())
+                                            : QString());
+}
+
+void DFPlayerFleetPanel::showDevice(int index)
+{
+    if (index >= ui->devices->rowCount())
+        return;
+
+    DFPlayerDevice &device = _fleet.device(index);
+    const DFPlayerState &state = device.state();
+    const DFPlayerDevice::Health &health = device.health();
+    const auto setText = [this, index](int column, const QString &text) {
+        ui->devices->item(index, column)->setText(text);
+    };
+
+    const QString error = _fleet.errorString(index);
+    setText(PortColumn, device.isOpen() || error.isEmpty() ? device.portName()
+                                                           : tr("%1: %2").arg(device.portName(), error));
+
+    QString link = tr("закрыт");
+    if (device.isOpen())
+    {
+        const bool silent = health.lastReplyAt == 0 || MonotonicClock::nowNs() - health.lastReplyAt > SILENCE_NS;
+        link = health.online && !silent ? tr("на связи") : tr("нет ответа");
+    }
+    setText(LinkColumn, link);
+
+    setText(StatusColumn, state.statusText());
+    setText(VolumeColumn, state.text(DFPlayerState::Volume));
+    setText(TrackColumn, state.text(DFPlayerState::SdTrack));
+    setText(RttColumn, health.rttNs < 0 ? QStringLiteral("-") : QString::number(health.rttNs * 1e-6, 'f', 1));
+    setText(RepliesColumn, QString::number(health.replies));
+    setText(TimeoutsColumn, QString::number(health.timeouts));
+    setText(ErrorsColumn, QString::number(health.errors));
+    setText(CorruptColumn, QString::number(device.counters().bad + device.counters().resynced));
+}
+
+void DFPlayerFleetPanel::showSkew(qint64 skewNs)
+{
+    ui->skew->setText(tr("разброс записи в порты %1 мс").arg(skewNs * 1e-6, 0, 'f', 2));
+}
+
+void DFPlayerFleetPanel::broadcast(DFPlayerCommands::Command command, quint16 first, quint16 second)
+{
+    if (_fleet.count() == 0)
+        return;
+
+    ui->skew->clear();
+    _fleet.broadcast(command, first, second);
+}
+
+void DFPlayerFleetPanel::on_openPorts_toggled(bool checked)
+{
+    if (!checked)
+    {
+        _fleet.close();
+        showDevices();
+        return;
+    }
+
+    QStringList ports;
+    for (const QString &port : ui->ports->text().split(','))
+    {
+        if (!port.trimmed().isEmpty())
+            ports.append(port.trimmed());
+    }
+    _fleet.open(ports, _settings.settings());
+    showDevices();
+}
+
+void DFPlayerFleetPanel::on_playAll_clicked()
+{
+    broadcast(DFPlayerCommands::PlayFolder, ui->folder->value(), ui->track->value());
+}
+
+void DFPlayerFleetPanel::on_pauseAll_clicked()
+{
+    broadcast(DFPlayerCommands::Pause);
+}
+
+void DFPlayerFleetPanel::on_resumeAll_clicked()
+{
+    broadcast(DFPlayerCommands::Play);
+}
+
+void DFPlayerFleetPanel::on_stopAll_clicked()
+{
+    broadcast(DFPlayerCommands::Stop);
+}
+
+void DFPlayerFleetPanel::on_volumeAll_clicked()
+{
+    broadcast(DFPlayerCommands::Volume, ui->volume->value());
+}
@@ -0,0 +1,43 @@
+#ifndef DFPLAYERFLEETPANEL_H
+#define DFPLAYERFLEETPANEL_H
+
+#include <QWidget>
+
+#include "dfplayerfleet.h"
+#include "settingsdialog.h"
+
+namespace Ui {
+class DFPlayerFleetPanel;
+}
+
+// Панель парка DFPlayer: список портов, общие команды всем модулям и таблица состояния и связи
+// по каждому устройству. Параметры портов, кроме имени, берутся из настроек терминала.
+class DFPlayerFleetPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DFPlayerFleetPanel(const SettingsDialog &settings, QWidget *parent = nullptr);
+    ~DFPlayerFleetPanel();
+
+private:
+    const SettingsDialog &_settings;
+    Ui::DFPlayerFleetPanel *ui;
+
+    DFPlayerFleet _fleet;
+
+    void showDevices();
+    void showDevice(int index);
+    void showSkew(qint64 skewNs);
+    void broadcast(DFPlayerCommands::Command command, quint16 first = 0, quint16 second = 0);
+
+private slots:
+    void on_openPorts_toggled(bool checked);
+    void on_playAll_clicked();
+    void on_pauseAll_clicked();
+    void on_resumeAll_clicked();
+    void on_stopAll_clicked();
+    void on_volumeAll_clicked();
+};
+
+#endif // DFPLAYERFLEETPANEL_H
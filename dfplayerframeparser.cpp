@@ -0,0 +1,114 @@
+#include "dfplayerframeparser.h"
+
+#include <cstring>
+
+static const uchar START_BYTE = 0x7E;
+static const uchar VERSION_BYTE = 0xFF;
+static const uchar LENGTH_BYTE = 0x06;
+static const uchar END_BYTE = 0xEF;
+
+void DFPlayerFrameParser::feed(const char *data, size_t size, quint64 offset, const Handler &handler)
+{
+    const uchar *pos = reinterpret_cast<const uchar *>(data);
+    const uchar *end = pos + size;
+
+    // Сначала дописывается пакет, начатый в прошлом участке
+    while (_filled > 0 && pos < end)
+    {
+        const size_t n = qMin(FRAME_SIZE - _filled, static_cast<size_t>(end - pos));
+        std::memcpy(_held + _filled, pos, n);
+        _filled += n;
+        pos += n;
+        offset += n;
+        if (_filled < FRAME_SIZE)
+            return;
+
+        const size_t shift = process(_held, _heldOffset, handler);
+        _filled = FRAME_SIZE - shift;
+        _heldOffset += shift;
+        if (_filled > 0)
+            std::memmove(_held, _held + shift, _filled);
+    }
+
+    while (pos < end)
+    {
+        const uchar *start = static_cast<const uchar *>(std::memchr(pos, START_BYTE, static_cast<size_t>(end - pos)));
+        if (!start)
+        {
+            _counters.skipped += static_cast<quint64>(end - pos);
+            return;
+        }
+
+        _counters.skipped += static_cast<quint64>(start - pos);
+        offset += static_cast<quint64>(start - pos);
+        pos = start;
+
+        // Хвост короче пакета ждёт следующего участка
+        if (static_cast<size_t>(end - pos) < FRAME_SIZE)
+        {
+            _filled = static_cast<size_t>(end - pos);
+            std::memcpy(_held, pos, _filled);
+            _heldOffset = offset;
+            return;
+        }
+
+        const size_t shift = process(pos, offset, handler);
+        pos += shift;
+        offset += shift;
+    }
+}
+
+void DFPlayerFrameParser::reset()
+{
+    _filled = 0;
+    _heldOffset = 0;
+    _counters = Counters();
+}
+
+const DFPlayerFrameParser::Counters &DFPlayerFrameParser::counters() const
+{
+    return _counters;
+}
+
+DFPlayerFrameParser::Status DFPlayerFrameParser::validate(const uchar *frame)
+{
+    if (frame[1] != VERSION_BYTE || frame[2] != LENGTH_BYTE || frame[9] != END_BYTE)
+        return FormatError;
+
+    // Сумма байт VER..LSB вместе с контрольной суммой даёт 0 по модулю 2^16
+    const quint16 sum = static_cast<quint16>(frame[1] + frame[2] + frame[3] + frame[4] + frame[5] + frame[6]);
+    const quint16 checksum = static_cast<quint16>((frame[7] << 8) | frame[8]);
+    return static_cast<quint16>(sum + checksum) == 0 ? Valid : ChecksumError;
+}
+
+size_t DFPlayerFrameParser::process(const uchar *frame, quint64 offset, const Handler &handler)
+{
+    Frame result;
+    result.offset = offset;
+    result.status = validate(frame);
+    result.data = frame;
+    result.command = frame[3];
+    result.feedback = frame[4];
+    result.value = static_cast<quint16>((frame[5] << 8) | frame[6]);
+
+    size_t shift = FRAME_SIZE;
+    if (result.status == Valid)
+        ++_counters.good;
+    else
+    {
+        if (result.status == ChecksumError)
+            ++_counters.bad;
+        else
+            ++_counters.resynced;
+
+        // Следующий кандидат может начинаться внутри повреждённого пакета
+        const void *next = std::memchr(frame + 1, START_BYTE, FRAME_SIZE - 1);
+        if (next)
+            shift = static_cast<size_t>(static_cast<const uchar *>(next) - frame);
+    }
+
+    result.length = static_cast<quint32>(shift);
+    if (handler)
+        handler(result);
+    return shift;
+}
@@ -0,0 +1,65 @@
+#ifndef DFPLAYERFRAMEPARSER_H
+#define DFPLAYERFRAMEPARSER_H
+
+#include <QtGlobal>
+
+#include <functional>
+
+// Разбор потока пакетов DFPlayer: 7E FF 06 CMD FEEDBACK MSB LSB CHK_MSB CHK_LSB EF.
+// Стартовый байт ищется memchr (векторизован в libc), пакет, целиком лежащий в поданном участке,
+// проверяется на месте; копируется только пакет, разрезанный между участками (не более 10 байт).
+// Повреждённый пакет не сдвигается побайтно: разбор продолжается со следующего байта 0x7E внутри него.
+class DFPlayerFrameParser
+{
+public:
+    static const size_t FRAME_SIZE = 10;
+
+    enum Status
+    {
+        Valid,
+        ChecksumError,  // формат верный, контрольная сумма нет
+        FormatError     // неверные VER, LEN или конечный байт
+    };
+
+    struct Frame
+    {
+        // Положение в потоке; у повреждённого пакета длина - до следующего кандидата
+        quint64 offset;
+        quint32 length;
+        Status status;
+        // FRAME_SIZE байт пакета, действительны только внутри обработчика
+        const uchar *data;
+        quint8 command;
+        quint8 feedback;
+        quint16 value;
+    };
+
+    struct Counters
+    {
+        quint64 good = 0;
+        quint64 bad = 0;        // ошибка контрольной суммы
+        quint64 resynced = 0;   // ошибка формата, поиск следующего начала
+        quint64 skipped = 0;    // байты вне пакетов
+    };
+
+    using Handler = std::function<void(const Frame &frame)>;
+
+    // offset - положение data в потоке, нужно только для Frame::offset
+    void feed(const char *data, size_t size, quint64 offset, const Handler &handler);
+    void reset();
+
+    const Counters &counters() const;
+
+private:
+    static Status validate(const uchar *frame);
+
+    // Обработать пакет в frame и вернуть, на сколько байт сдвинуться до следующего кандидата
+    size_t process(const uchar *frame, quint64 offset, const Handler &handler);
+
+    uchar _held[FRAME_SIZE];
+    size_t _filled = 0;
+    quint64 _heldOffset = 0;
+    Counters _counters;
+};
+
+#endif // DFPLAYERFRAMEPARSER_H
@@ -0,0 +1,214 @@
+#include "dfplayerplaylist.h"
+#include "dfplayercommands.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+#include <numeric>
+
+DFPlayerPlaylist::DFPlayerPlaylist(DFPlayerCommandQueue &queue, QObject *parent)
+    : QObject(parent)
+    , _queue(queue)
+    , _random(std::random_device{}())
+{
+    connect(&_queue, &DFPlayerCommandQueue::frameSent, this, &DFPlayerPlaylist::frameSent);
+}
+
+bool DFPlayerPlaylist::setEntries(const std::vector<Entry> &entries)
+{
+    // Пустой пакет в середине списка молча завершил бы плейлист
+    if (!std::all_of(entries.begin(), entries.end(), &DFPlayerPlaylist::isPlayable))
+        return false;
+
+    const int playing = current();
+    _entries = entries;
+    if (!_active)
+        return true;
+
+    if (_entries.empty())
+    {
+        stop();
+        emit finished();
+        return true;
+    }
+    // Текущий трек доигрывает, порядок строится заново от него
+    buildOrder(qBound(0, playing, static_cast<int>(_entries.size()) - 1));
+    stage();
+    return true;
+}
+
+const std::vector<DFPlayerPlaylist::Entry> &DFPlayerPlaylist::entries() const
+{
+    return _entries;
+}
+
+bool DFPlayerPlaylist::isPlayable(const Entry &entry)
+{
+    return !frameOf(entry).isEmpty();
+}
+
+void DFPlayerPlaylist::setShuffle(bool shuffle)
+{
+    if (_shuffle == shuffle)
+        return;
+
+    _shuffle = shuffle;
+    if (_active)
+    {
+        buildOrder(current());
+        stage();
+    }
+}
+
+void DFPlayerPlaylist::setRepeat(bool repeat)
+{
+    _repeat = repeat;
+    if (_active)
+        stage();
+}
+
+void DFPlayerPlaylist::setFrameTime(qint64 nanoseconds)
+{
+    _frameTimeNs = nanoseconds;
+}
+
+bool DFPlayerPlaylist::start(int index)
+{
+    if (_entries.empty())
+        return false;
+
+    index = qBound(0, index, static_cast<int>(_entries.size()) - 1);
+    _active = true;
+    _gaps = {};
+    _switchFrame.clear();
+    buildOrder(index);
+    _queue.enqueue(frameOf(_entries[index]));
+    emit currentChanged(index);
+    stage();
+    return true;
+}
+
+void DFPlayerPlaylist::stop()
+{
+    _active = false;
+    _position = -1;
+    _staged.clear();
+    _stagedPosition = -1;
+    _nextOrder.clear();
+    _switchFrame.clear();
+}
+
+bool DFPlayerPlaylist::isActive() const
+{
+    return _active;
+}
+
+int DFPlayerPlaylist::current() const
+{
+    return _active && _position >= 0 ? _order[_position] : -1;
+}
+
+bool DFPlayerPlaylist::announce(int advert)
+{
+    const QByteArray frame = DFPlayerCommands::encode(DFPlayerCommands::PlayAdvertisement, advert);
+    if (!_active || frame.isEmpty())
+        return false;
+
+    _queue.enqueue(frame);
+    return true;
+}
+
+void DFPlayerPlaylist::messageReceived(quint8 command, quint16 value, qint64 timestamp)
+{
+    if (!_active || (command != CMD_TRACK_FINSH_USB && command != CMD_TRACK_FINSH_SD))
+        return;
+
+    if (_staged.isEmpty())
+    {
+        stop();
+        emit finished();
+        return;
+    }
+
+    // Пакет уже собран: до записи в порт остаётся только очередь
+    _switchFrame = _staged;
+    _finishedAt = timestamp;
+    if (!_nextOrder.empty())
+        _order.swap(_nextOrder);
+    _position = _stagedPosition;
+    _queue.enqueueFirst(_staged);
+    emit currentChanged(current());
+    stage();
+}
+
+const DFPlayerPlaylist::GapStatistics &DFPlayerPlaylist::gaps() const
+{
+    return _gaps;
+}
+
+void DFPlayerPlaylist::buildOrder(int first)
+{
+    _order.resize(_entries.size());
+    std::iota(_order.begin(), _order.end(), 0);
+    if (_shuffle)
+    {
+        std::shuffle(_order.begin(), _order.end(), _random);
+        std::iter_swap(_order.begin(), std::find(_order.begin(), _order.end(), first));
+    }
+    else
+    {
+        std::rotate(_order.begin(), _order.begin() + first, _order.end());
+    }
+    _position = 0;
+}
+
+void DFPlayerPlaylist::stage()
+{
+    _stagedPosition = _position + 1;
+    _nextOrder.clear();
+    if (_stagedPosition >= static_cast<int>(_order.size()))
+    {
+        if (!_repeat)
+        {
+            _staged.clear();
+            _stagedPosition = -1;
+            return;
+        }
+        // Новый круг начнётся по сообщению об окончании; при перемешивании - в новом порядке,
+        // и только что сыгранный трек не повторяется сразу
+        _nextOrder = _order;
+        if (_shuffle && _nextOrder.size() > 1)
+        {
+            std::shuffle(_nextOrder.begin(), _nextOrder.end(), _random);
+            if (_nextOrder.front() == current())
+                std::iter_swap(_nextOrder.begin(), _nextOrder.end() - 1);
+        }
+        _stagedPosition = 0;
+    }
+    const std::vector<int> &order = _nextOrder.empty() ? _order : _nextOrder;
+    _staged = frameOf(_entries[order[_stagedPosition]]);
+}
+
+void DFPlayerPlaylist::frameSent(const QByteArray &frame)
+{
+    if (_switchFrame.isEmpty() || !DFPlayerCommands::sameCommand(frame, _switchFrame))
+        return;
+
+    _switchFrame.clear();
+    // От приёма сообщения об окончании до конца передачи команды следующего трека
+    const qint64 gapNs = MonotonicClock::nowNs() - _finishedAt + _frameTimeNs;
+    _gaps.lastNs = gapNs;
+    _gaps.minNs = _gaps.samples ? qMin(_gaps.minNs, gapNs) : gapNs;
+    _gaps.maxNs = qMax(_gaps.maxNs, gapNs);
+    _gaps.totalNs += gapNs;
+    _gaps.samples++;
+    emit gapMeasured(gapNs);
+}
+
+QByteArray DFPlayerPlaylist::frameOf(const Entry &entry)
+{
+    if (entry.folder == 0)
+        return DFPlayerCommands::encode(DFPlayerCommands::PlayTrack, entry.track);
+    if (entry.folder <= 99 && entry.track <= 255)
+        return DFPlayerCommands::encode(DFPlayerCommands::PlayFolder, entry.folder, entry.track);
+    return DFPlayerCommands::encode(DFPlayerCommands::PlayLargeFolder, entry.folder, entry.track);
+}
@@ -0,0 +1,102 @@
+#ifndef DFPLAYERPLAYLIST_H
+#define DFPLAYERPLAYLIST_H
+
+#include <QByteArray>
+#include <QObject>
+
+#include <random>
+#include <vector>
+
+#include "dfplayercommandqueue.h"
+
+// Плейлист DFPlayer: список треков (папка/трек или номер файла в корне), перемешивание, повтор по кругу,
+// объявления поверх трека (playAdvertisement).
+// Пакет следующего трека собирается заранее, пока играет текущий. Сообщение модуля об окончании трека
+// (0x3C/0x3D) обрабатывается в том же вызове, что разобрал его из порта, и готовый пакет ставится
+// впереди очереди: при свободном порту он записывается сразу, пауза между треками - время передачи
+// пакета и реакция модуля, а не задержка GUI или опроса. Измеренные паузы копятся в статистике.
+class DFPlayerPlaylist : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        int folder;     // 0 - номер файла в корне носителя
+        int track;
+    };
+
+    struct GapStatistics
+    {
+        quint64 samples = 0;
+        qint64 lastNs = 0;
+        qint64 minNs = 0;
+        qint64 maxNs = 0;
+        qint64 totalNs = 0;
+    };
+
+    explicit DFPlayerPlaylist(DFPlayerCommandQueue &queue, QObject *parent = nullptr);
+
+    // false - в списке есть трек, который нельзя запустить (папка или номер вне диапазона команд)
+    bool setEntries(const std::vector<Entry> &entries);
+    const std::vector<Entry> &entries() const;
+    static bool isPlayable(const Entry &entry);
+
+    void setShuffle(bool shuffle);
+    void setRepeat(bool repeat);
+    // Время передачи пакета по линии - входит в измеренную паузу
+    void setFrameTime(qint64 nanoseconds);
+
+    bool start(int index = 0);
+    void stop();
+    bool isActive() const;
+    // Номер играющего элемента в entries(), -1 - плейлист не запущен
+    int current() const;
+
+    // Объявление из папки ADVERT поверх текущего трека, после него трек продолжается
+    bool announce(int advert);
+
+    // Пакет от модуля; timestamp - время его приёма из порта.
+    // Повтор сообщения об окончании трека сюда не передаётся (DFPlayerState::isRepeatedFinish)
+    void messageReceived(quint8 command, quint16 value, qint64 timestamp);
+
+    const GapStatistics &gaps() const;
+
+signals:
+    void currentChanged(int index);
+    void finished();
+    void gapMeasured(qint64 nanoseconds);
+
+private:
+    void buildOrder(int first);
+    void stage();
+    void frameSent(const QByteArray &frame);
+
+    static QByteArray frameOf(const Entry &entry);
+
+    DFPlayerCommandQueue &_queue;
+
+    std::vector<Entry> _entries;
+    // Порядок воспроизведения (индексы entries) и положение в нём
+    std::vector<int> _order;
+    int _position = -1;
+    bool _shuffle = false;
+    bool _repeat = false;
+    bool _active = false;
+    std::mt19937 _random;
+
+    // Заранее собранный пакет следующего трека; пустой - текущий последний
+    QByteArray _staged;
+    int _stagedPosition = -1;
+    // Порядок следующего круга, если следующий трек его начинает
+    std::vector<int> _nextOrder;
+
+    // Окончание трека, по которому отправлен следующий, - для замера паузы
+    QByteArray _switchFrame;
+    qint64 _finishedAt = 0;
+    qint64 _frameTimeNs = 0;
+
+    GapStatistics _gaps;
+};
+
+#endif // DFPLAYERPLAYLIST_H
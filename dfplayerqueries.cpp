@@ -0,0 +1,122 @@
+#include "dfplayerqueries.h"
+#include "dfplayercommands.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+
+DFPlayerQueries::DFPlayerQueries(QObject *parent)
+    : QObject(parent)
+{
+    _timer.setSingleShot(true);
+    connect(&_timer, &QTimer::timeout, this, &DFPlayerQueries::checkTimeouts);
+}
+
+void DFPlayerQueries::expect(quint8 command, Callback callback, int timeout)
+{
+    _pending.push_back({command, std::move(callback), timeout, false, 0});
+}
+
+void DFPlayerQueries::enqueue(DFPlayerCommandQueue &queue, const QByteArray &frame, Callback callback, int timeout)
+{
+    // Ожидание ставится до отправки: пакет может уйти сразу из enqueue
+    expect(static_cast<quint8>(frame[CMD_VALUE]), std::move(callback), timeout);
+    queue.enqueue(frame);
+}
+
+void DFPlayerQueries::markSent(quint8 command)
+{
+    _lastSent = command;
+    auto it = std::find_if(_pending.begin(), _pending.end(),
+                           [command](const Pending &pending) { return !pending.sent && pending.command == command; });
+    if (it == _pending.end())
+        return;
+
+    it->sent = true;
+    it->deadline = MonotonicClock::nowNs() + it->timeout * MonotonicClock::NS_PER_MS;
+    scheduleTimeout();
+}
+
+bool DFPlayerQueries::handleReply(quint8 command, quint16 value)
+{
+    auto it = std::find_if(_pending.begin(), _pending.end(),
+                           [command](const Pending &pending) { return pending.sent && pending.command == command; });
+    if (it == _pending.end())
+        return false;
+
+    complete(it, true, value);
+    return true;
+}
+
+void DFPlayerQueries::handleError(quint16 code)
+{
+    const quint8 command = _lastSent;
+    auto it = std::find_if(_pending.begin(), _pending.end(),
+                           [command](const Pending &pending) { return pending.sent && pending.command == command; });
+    if (command == 0 || it == _pending.end())
+        return;
+
+    _lastSent = 0;
+    complete(it, false, code);
+}
+
+void DFPlayerQueries::cancelAll()
+{
+    // Обработчик может поставить новые запросы - завершаем только те, что были на момент вызова
+    std::deque<Pending> pending;
+    pending.swap(_pending);
+    _lastSent = 0;
+    _timer.stop();
+
+    for (Pending &query : pending)
+        query.callback(false, 0);
+}
+
+int DFPlayerQueries::pending() const
+{
+    return static_cast<int>(_pending.size());
+}
+
+void DFPlayerQueries::complete(std::deque<Pending>::iterator it, bool ok, quint16 value)
+{
+    // Ожидание снимается до вызова: обработчик может сразу поставить зависящие запросы
+    const Callback callback = std::move(it->callback);
+    _pending.erase(it);
+    scheduleTimeout();
+
+    if (callback)
+        callback(ok, value);
+}
+
+void DFPlayerQueries::checkTimeouts()
+{
+    const qint64 now = MonotonicClock::nowNs();
+    auto it = std::find_if(_pending.begin(), _pending.end(),
+                           [now](const Pending &pending) { return pending.sent && pending.deadline <= now; });
+    while (it != _pending.end())
+    {
+        complete(it, false, 0);
+        it = std::find_if(_pending.begin(), _pending.end(),
+                          [now](const Pending &pending) { return pending.sent && pending.deadline <= now; });
+    }
+    scheduleTimeout();
+}
+
+void DFPlayerQueries::scheduleTimeout()
+{
+    // Один таймер на ближайший срок среди отправленных запросов
+    qint64 nearest = -1;
+    for (const Pending &pending : _pending)
+    {
+        if (pending.sent && (nearest < 0 || pending.deadline < nearest))
+            nearest = pending.deadline;
+    }
+
+    if (nearest < 0)
+    {
+        _timer.stop();
+        return;
+    }
+
+    const qint64 wait = qMax<qint64>(0, nearest - MonotonicClock::nowNs());
+    _timer.start(static_cast<int>((wait + MonotonicClock::NS_PER_MS - 1) / MonotonicClock::NS_PER_MS));
+}
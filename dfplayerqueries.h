@@ -0,0 +1,66 @@
+#ifndef DFPLAYERQUERIES_H
+#define DFPLAYERQUERIES_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <deque>
+#include <functional>
+
+#include "dfplayercommandqueue.h"
+
+// Ожидание ответов DFPlayer на запросы. Модуль отвечает пакетом с тем же кодом команды,
+// поэтому ответ сопоставляется с самым старым отправленным запросом этого кода.
+// Ошибка (CMD_ERROR) относится к запросу, только если он был последним записанным в порт пакетом:
+// иначе она ответ на команду, ушедшую после него.
+// Время ожидания отсчитывается с момента фактической отправки запроса, а не постановки в очередь.
+class DFPlayerQueries : public QObject
+{
+    Q_OBJECT
+
+public:
+    // ok == false - ответ с ошибкой или истекло время ожидания
+    using Callback = std::function<void(bool ok, quint16 value)>;
+
+    static const int DEFAULT_TIMEOUT = 500;
+
+    explicit DFPlayerQueries(QObject *parent = nullptr);
+
+    // Зарегистрировать ожидание ответа перед постановкой запроса в очередь
+    void expect(quint8 command, Callback callback, int timeout = DEFAULT_TIMEOUT);
+    // Поставить запрос в очередь, ожидая ответ с кодом его команды
+    void enqueue(DFPlayerCommandQueue &queue, const QByteArray &frame, Callback callback,
+                 int timeout = DEFAULT_TIMEOUT);
+    // Пакет с этим кодом записан в порт; для запроса начинается отсчёт времени
+    void markSent(quint8 command);
+
+    // Пакет от модуля: true, если он был ответом на запрос
+    bool handleReply(quint8 command, quint16 value);
+    void handleError(quint16 code);
+
+    // Все ожидания завершаются с ошибкой
+    void cancelAll();
+
+    int pending() const;
+
+private:
+    struct Pending
+    {
+        quint8 command;
+        Callback callback;
+        int timeout;
+        bool sent;
+        qint64 deadline;
+    };
+
+    void complete(std::deque<Pending>::iterator it, bool ok, quint16 value);
+    void checkTimeouts();
+    void scheduleTimeout();
+
+    std::deque<Pending> _pending;
+    // Код последнего записанного пакета, 0 - ошибка уже отнесена к нему
+    quint8 _lastSent = 0;
+    QTimer _timer;
+};
+
+#endif // DFPLAYERQUERIES_H
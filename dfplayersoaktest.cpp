@@ -0,0 +1,331 @@
+#include "dfplayersoaktest.h"
+#include "monotonicclock.h"
+
+#include <QDateTime>
+
+static const qint64 NS_PER_US = 1000;
+
+// Состав смеси: запросы и настройки не меняют воспроизведение, команды воспроизведения - по выбору
+static const DFPlayerCommands::Command QUERIES[] = {
+    DFPlayerCommands::QueryStatus, DFPlayerCommands::QueryVolume, DFPlayerCommands::QueryEqualizer,
+    DFPlayerCommands::QueryUsbFiles, DFPlayerCommands::QuerySdFiles, DFPlayerCommands::QueryUsbTrack,
+    DFPlayerCommands::QuerySdTrack, DFPlayerCommands::QueryFolders
+};
+static const DFPlayerCommands::Command SETTINGS[] = {
+    DFPlayerCommands::Volume, DFPlayerCommands::Equalizer
+};
+static const DFPlayerCommands::Command TRANSPORT[] = {
+    DFPlayerCommands::Next, DFPlayerCommands::Previous, DFPlayerCommands::Pause, DFPlayerCommands::Play
+};
+
+void DFPlayerSoakTest::Histogram::add(qint64 nanoseconds)
+{
+    int bucket = 0;
+    for (qint64 limit = NS_PER_US; bucket < BUCKETS - 1 && nanoseconds > limit; limit <<= 1)
+        ++bucket;
+
+    ++counts[static_cast<size_t>(bucket)];
+    minNs = samples ? qMin(minNs, nanoseconds) : nanoseconds;
+    maxNs = qMax(maxNs, nanoseconds);
+    totalNs += nanoseconds;
+    ++samples;
+}
+
+qint64 DFPlayerSoakTest::Histogram::percentileNs(double p) const
+{
+    if (!samples)
+        return 0;
+
+    const quint64 rank = static_cast<quint64>(p * (samples - 1)) + 1;
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket)
+    {
+        seen += counts[static_cast<size_t>(bucket)];
+        if (seen >= rank)
+            return qMin(maxNs, NS_PER_US << bucket);
+    }
+    return maxNs;
+}
+
+DFPlayerSoakTest::DFPlayerSoakTest(DFPlayerCommandQueue &queue, DFPlayerQueries &queries, QObject *parent)
+    : QObject(parent),
+      _queue(queue),
+      _queries(queries)
+{
+    _endTimer.setSingleShot(true);
+    connect(&_endTimer, &QTimer::timeout, this, &DFPlayerSoakTest::stop);
+    connect(&_progressTimer, &QTimer::timeout, this, &DFPlayerSoakTest::progress);
+    _watchdog.setSingleShot(true);
+    connect(&_watchdog, &QTimer::timeout, this, [this]() { complete(TimedOut); });
+
+    connect(&_queue, &DFPlayerCommandQueue::frameSent, this, &DFPlayerSoakTest::frameSent);
+    connect(&_queue, &DFPlayerCommandQueue::frameAcknowledged, this, &DFPlayerSoakTest::frameAcknowledged);
+    connect(&_queue, &DFPlayerCommandQueue::frameRetransmitted, this, &DFPlayerSoakTest::frameRetransmitted);
+    connect(&_queue, &DFPlayerCommandQueue::frameFailed, this, &DFPlayerSoakTest::frameFailed);
+}
+
+void DFPlayerSoakTest::start(const Settings &settings)
+{
+    if (_running)
+        return;
+
+    _settings = settings;
+    _random.seed(settings.seed);
+    _commands = {};
+    _errorCodes.clear();
+    _checksumErrors = 0;
+    _resyncs = 0;
+
+    _running = true;
+    _startedAt = MonotonicClock::nowNs();
+    _stoppedAt = 0;
+    _endTimer.start(settings.durationMinutes * 60 * 1000);
+    _progressTimer.start(1000);
+
+    issueNext();
+}
+
+void DFPlayerSoakTest::stop()
+{
+    if (!_running)
+        return;
+
+    _running = false;
+    _stoppedAt = MonotonicClock::nowNs();
+    _waiting = false;
+    ++_sequence;
+    _endTimer.stop();
+    _progressTimer.stop();
+    _watchdog.stop();
+
+    emit progress();
+    emit finished();
+}
+
+bool DFPlayerSoakTest::isRunning() const
+{
+    return _running;
+}
+
+void DFPlayerSoakTest::messageReceived(quint8 command, quint16 value)
+{
+    if (!_running || command != CMD_ERROR)
+        return;
+
+    ++_errorCodes[value];
+    if (!_waiting)
+        return;
+
+    // В режиме подтверждения команду управления после ошибки повторяет очередь: её итог придёт
+    // через frameAcknowledged или frameFailed
+    const bool control = DFPlayerCommands::TABLE[_outstanding].reply == 0;
+    if (control && _queue.isReliable())
+        return;
+
+    ++_commands[_outstanding].errors;
+    // Ответ на запрос с ошибкой завершает его через DFPlayerQueries, команда управления завершается здесь
+    if (control && _sentAt != 0)
+        complete(Failed);
+}
+
+void DFPlayerSoakTest::frameRejected(DFPlayerFrameParser::Status status)
+{
+    if (!_running)
+        return;
+
+    if (status == DFPlayerFrameParser::ChecksumError)
+        ++_checksumErrors;
+    else
+        ++_resyncs;
+}
+
+void DFPlayerSoakTest::issueNext()
+{
+    if (!_running || _waiting)
+        return;
+
+    quint16 param = 0;
+    const DFPlayerCommands::Command command = pickCommand(param);
+    const QByteArray frame = DFPlayerCommands::encode(command, param);
+
+    _waiting = true;
+    const quint64 sequence = ++_sequence;
+    _outstanding = command;
+    _outstandingFrame = frame;
+    _sentAt = 0;
+    _watchdog.start(WATCHDOG_TIMEOUT);
+
+    if (DFPlayerCommands::TABLE[command].reply == 0)
+    {
+        _queue.enqueue(frame);
+        return;
+    }
+
+    _queries.enqueue(_queue, frame, [this, sequence](bool ok, quint16 value) {
+        if (sequence != _sequence || !_waiting)
+            return;
+        // Код ошибки уже учтён в messageReceived
+        if (ok)
+            complete(Completed, MonotonicClock::nowNs() - _sentAt);
+        else
+            complete(value ? Failed : TimedOut);
+    });
+}
+
+DFPlayerCommands::Command DFPlayerSoakTest::pickCommand(quint16 &param)
+{
+    DFPlayerCommands::Command command;
+    if (static_cast<int>(_random() % 100) < _settings.queryPercent)
+        command = QUERIES[_random() % (sizeof(QUERIES) / sizeof(QUERIES[0]))];
+    else if (_settings.transport && _random() % 2)
+        command = TRANSPORT[_random() % (sizeof(TRANSPORT) / sizeof(TRANSPORT[0]))];
+    else
+        command = SETTINGS[_random() % (sizeof(SETTINGS) / sizeof(SETTINGS[0]))];
+
+    // Параметр - случайный из допустимых по таблице команд
+    const DFPlayerCommands::Range range = DFPlayerCommands::TABLE[command].first;
+    param = DFPlayerCommands::TABLE[command].layout == DFPlayerCommands::Layout::Word
+            ? static_cast<quint16>(range.min + _random() % (range.max - range.min + 1u)) : 0;
+    return command;
+}
+
+void DFPlayerSoakTest::frameSent(const QByteArray &frame)
+{
+    if (!_waiting || _sentAt != 0 || !DFPlayerCommands::sameCommand(frame, _outstandingFrame))
+        return;
+
+    // Отправленный пакет может отличаться битом FEEDBACK - подтверждение сравнивается с ним
+    _outstandingFrame = frame;
+    _sentAt = MonotonicClock::nowNs();
+    ++_commands[_outstanding].sent;
+
+    // Без режима подтверждения команда управления завершена отправкой, времени отклика у неё нет
+    if (DFPlayerCommands::TABLE[_outstanding].reply == 0 && !_queue.isReliable())
+        complete(Completed);
+}
+
+void DFPlayerSoakTest::frameAcknowledged(const QByteArray &frame, qint64 rttNs)
+{
+    if (!_waiting || _sentAt == 0 || frame != _outstandingFrame)
+        return;
+
+    // Время повторённого пакета считается от первой отправки
+    complete(Completed, rttNs >= 0 ? rttNs : MonotonicClock::nowNs() - _sentAt);
+}
+
+void DFPlayerSoakTest::frameRetransmitted(const QByteArray &frame)
+{
+    if (_waiting && frame == _outstandingFrame)
+        ++_commands[_outstanding].retransmits;
+}
+
+void DFPlayerSoakTest::frameFailed(const QByteArray &frame)
+{
+    if (_waiting && frame == _outstandingFrame)
+        complete(TimedOut);
+}
+
+void DFPlayerSoakTest::complete(Outcome outcome, qint64 latencyNs)
+{
+    if (!_waiting)
+        return;
+
+    CommandStatistics &statistics = _commands[_outstanding];
+    if (outcome == Completed)
+    {
+        ++statistics.completed;
+        if (latencyNs >= 0)
+            statistics.latency.add(latencyNs);
+    }
+    else if (outcome == TimedOut)
+        ++statistics.timeouts;
+
+    _waiting = false;
+    _watchdog.stop();
+
+    // Следующая команда ставится вне обработчика сигнала очереди
+    QTimer::singleShot(0, this, &DFPlayerSoakTest::issueNext);
+}
+
+QString DFPlayerSoakTest::summary() const
+{
+    quint64 completed = 0;
+    quint64 timeouts = 0;
+    quint64 errors = 0;
+    for (const CommandStatistics &statistics : _commands)
+    {
+        completed += statistics.completed;
+        timeouts += statistics.timeouts;
+        errors += statistics.errors;
+    }
+
+    const qint64 elapsedNs = (_running ? MonotonicClock::nowNs() : _stoppedAt) - _startedAt;
+    const qint64 remaining = _running ? _endTimer.remainingTime() / 1000 : 0;
+    return tr("%1 команд, %2/с, ожидание истекло %3, ошибок %4, сбоев приёма %5, осталось %6:%7")
+            .arg(completed)
+            .arg(elapsedNs > 0 ? completed * 1e9 / elapsedNs : 0.0, 0, 'f', 1)
+            .arg(timeouts).arg(errors).arg(_checksumErrors + _resyncs)
+            .arg(remaining / 60).arg(remaining % 60, 2, 10, QChar('0'));
+}
+
+QString DFPlayerSoakTest::report() const
+{
+    const auto ms = [](qint64 nanoseconds) { return QString::number(nanoseconds / 1e6, 'f', 2); };
+
+    const qint64 elapsedNs = (_running ? MonotonicClock::nowNs() : _stoppedAt) - _startedAt;
+    QString text;
+    text += QStringLiteral("DFPlayer soak test, %1\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate));
+    text += QStringLiteral("duration %1 s, queries %2%, transport %3, seed %4, acknowledged mode %5\n\n")
+            .arg(elapsedNs / 1e9, 0, 'f', 0).arg(_settings.queryPercent)
+            .arg(_settings.transport ? "on" : "off").arg(_settings.seed)
+            .arg(_queue.isReliable() ? "on" : "off");
+
+    text += QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11\n")
+            .arg("command", -18).arg("sent", 8).arg("ok", 8).arg("timeout", 8).arg("error", 8).arg("retry", 8)
+            .arg("min ms", 9).arg("p50", 9).arg("p99", 9).arg("p99.9", 9).arg("max", 9);
+    for (int command = 0; command < DFPlayerCommands::COMMAND_COUNT; ++command)
+    {
+        const CommandStatistics &statistics = _commands[static_cast<size_t>(command)];
+        if (!statistics.sent && !statistics.timeouts)
+            continue;
+
+        const Histogram &latency = statistics.latency;
+        text += QStringLiteral("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11\n")
+                .arg(DFPlayerCommands::TABLE[command].name, -18)
+                .arg(statistics.sent, 8).arg(statistics.completed, 8).arg(statistics.timeouts, 8)
+                .arg(statistics.errors, 8).arg(statistics.retransmits, 8)
+                .arg(ms(latency.minNs), 9).arg(ms(latency.percentileNs(0.5)), 9)
+                .arg(ms(latency.percentileNs(0.99)), 9).arg(ms(latency.percentileNs(0.999)), 9)
+                .arg(ms(latency.maxNs), 9);
+    }
+
+    text += QStringLiteral("\nerror codes (0x40):");
+    if (_errorCodes.empty())
+        text += QStringLiteral(" none");
+    for (const auto &code : _errorCodes)
+        text += QStringLiteral(" 0x%1: %2").arg(code.first, 0, 16).arg(code.second);
+    text += QStringLiteral("\nreceive: checksum errors %1, resyncs %2\n").arg(_checksumErrors).arg(_resyncs);
+
+    // Гистограммы: только непустые корзины, граница - верхняя
+    text += QStringLiteral("\nlatency histograms, count per bucket (upper bound):\n");
+    for (int command = 0; command < DFPlayerCommands::COMMAND_COUNT; ++command)
+    {
+        const Histogram &latency = _commands[static_cast<size_t>(command)].latency;
+        if (!latency.samples)
+            continue;
+
+        text += QStringLiteral("%1").arg(DFPlayerCommands::TABLE[command].name, -18);
+        for (int bucket = 0; bucket < Histogram::BUCKETS; ++bucket)
+        {
+            const quint64 count = latency.counts[static_cast<size_t>(bucket)];
+            if (!count)
+                continue;
+            const QString bound = bucket == Histogram::BUCKETS - 1
+                    ? QStringLiteral(">%1").arg(ms(NS_PER_US << (bucket - 1)))
+                    : QStringLiteral("<=%1").arg(ms(NS_PER_US << bucket));
+            text += QStringLiteral(" %1ms:%2").arg(bound).arg(count);
+        }
+        text += '\n';
+    }
+    return text;
+}
@@ -0,0 +1,123 @@
+#ifndef DFPLAYERSOAKTEST_H
+#define DFPLAYERSOAKTEST_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+#include <map>
+#include <random>
+
+#include "dfplayercommandqueue.h"
+#include "dfplayercommands.h"
+#include "dfplayerframeparser.h"
+#include "dfplayerqueries.h"
+
+// Длительная проверка модуля смесью команд управления и запросов.
+// В работе всегда одна команда теста: следующая ставится в очередь, как только предыдущая завершена
+// (ответ на запрос, подтверждение 0x41, ошибка или истечение ожидания). Паузы между пакетами
+// выдерживает DFPlayerCommandQueue - это и есть наибольшая безопасная для модуля скорость.
+// Время отклика копится в логарифмических гистограммах: память не растёт за часы работы.
+class DFPlayerSoakTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings
+    {
+        int queryPercent = 50;      // доля запросов в смеси
+        bool transport = false;     // команды воспроизведения (next, pause...) - модуль будет играть
+        int durationMinutes = 60;
+        quint32 seed = 1;
+    };
+
+    // Корзина i - время до 2^i мкс; последняя собирает всё, что дольше
+    struct Histogram
+    {
+        static const int BUCKETS = 24;
+
+        std::array<quint64, BUCKETS> counts = {};
+        quint64 samples = 0;
+        qint64 minNs = 0;
+        qint64 maxNs = 0;
+        qint64 totalNs = 0;
+
+        void add(qint64 nanoseconds);
+        // Верхняя граница корзины, в которую попадает доля p замеров
+        qint64 percentileNs(double p) const;
+    };
+
+    struct CommandStatistics
+    {
+        quint64 sent = 0;
+        quint64 completed = 0;
+        quint64 timeouts = 0;
+        quint64 errors = 0;
+        quint64 retransmits = 0;
+        Histogram latency;
+    };
+
+    // Ожидание завершения команды сверх собственных сроков очереди и запросов
+    static const int WATCHDOG_TIMEOUT = 5000;
+
+    DFPlayerSoakTest(DFPlayerCommandQueue &queue, DFPlayerQueries &queries, QObject *parent = nullptr);
+
+    void start(const Settings &settings);
+    void stop();
+    bool isRunning() const;
+
+    // Пакеты модуля и отброшенные парсером пакеты передаёт панель
+    void messageReceived(quint8 command, quint16 value);
+    void frameRejected(DFPlayerFrameParser::Status status);
+
+    // Одна строка для панели и полный отчёт для файла
+    QString summary() const;
+    QString report() const;
+
+signals:
+    void progress();
+    void finished();
+
+private:
+    enum Outcome
+    {
+        Completed,
+        TimedOut,
+        Failed
+    };
+
+    void issueNext();
+    DFPlayerCommands::Command pickCommand(quint16 &param);
+    void frameSent(const QByteArray &frame);
+    void frameAcknowledged(const QByteArray &frame, qint64 rttNs);
+    void frameRetransmitted(const QByteArray &frame);
+    void frameFailed(const QByteArray &frame);
+    void complete(Outcome outcome, qint64 latencyNs = -1);
+
+    DFPlayerCommandQueue &_queue;
+    DFPlayerQueries &_queries;
+
+    Settings _settings;
+    bool _running = false;
+    std::mt19937 _random;
+    qint64 _startedAt = 0;
+    qint64 _stoppedAt = 0;
+    QTimer _endTimer;
+    QTimer _progressTimer;
+    QTimer _watchdog;
+
+    // Команда теста в работе
+    bool _waiting = false;
+    quint64 _sequence = 0;
+    DFPlayerCommands::Command _outstanding = DFPlayerCommands::QueryStatus;
+    QByteArray _outstandingFrame;
+    qint64 _sentAt = 0;
+
+    std::array<CommandStatistics, DFPlayerCommands::COMMAND_COUNT> _commands;
+    std::map<quint16, quint64> _errorCodes;
+    quint64 _checksumErrors = 0;
+    quint64 _resyncs = 0;
+};
+
+#endif // DFPLAYERSOAKTEST_H
@@ -0,0 +1,254 @@
+#include "dfplayerstate.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Поля, зависящие от воспроизводимого трека
+static const quint32 PLAYBACK = (1u << DFPlayerState::Status) | (1u << DFPlayerState::UsbTrack)
+                              | (1u << DFPlayerState::SdTrack);
+// Поля, зависящие от содержимого носителей
+static const quint32 MEDIA = PLAYBACK | (1u << DFPlayerState::UsbFiles) | (1u << DFPlayerState::SdFiles)
+                           | (1u << DFPlayerState::Folders);
+static const quint32 ALL = (1u << DFPlayerState::FIELD_COUNT) - 1;
+
+DFPlayerState::DFPlayerState(QObject *parent)
+    : QObject(parent)
+{
+    std::fill(std::begin(_values), std::end(_values), -1);
+}
+
+bool DFPlayerState::isValid(Field field) const
+{
+    return _valid & bit(field);
+}
+
+int DFPlayerState::value(Field field) const
+{
+    return isValid(field) ? _values[field] : -1;
+}
+
+bool DFPlayerState::isPlaying() const
+{
+    return isValid(Status) && (_values[Status] & 0xFF) == 1;
+}
+
+QString DFPlayerState::text(Field field) const
+{
+    return isValid(field) ? QString::number(_values[field]) : QStringLiteral("?");
+}
+
+QString DFPlayerState::statusText() const
+{
+    if (!isValid(Status))
+        return QStringLiteral("?");
+
+    const int value = _values[Status];
+    if ((value >> 8) == 0x10)
+        return tr("сон");
+    return (value & 0xFF) == 1 ? tr("воспроизведение") : (value & 0xFF) == 2 ? tr("пауза") : tr("стоп");
+}
+
+void DFPlayerState::commandSent(quint8 opcode, quint16 param)
+{
+    switch (opcode)
+    {
+    // Явно заданное значение известно без запроса
+    case CTRL_VOLUME:
+        set(Volume, param & 0xFF);
+        break;
+    case CTRL_EQ:
+        set(Equalizer, param & 0xFF);
+        break;
+
+    case CTRL_INC_VOL:
+    case CTRL_DEC_VOL:
+        invalidate(Volume);
+        break;
+
+    // Режимы повтора: по окончании трека модуль продолжает воспроизведение
+    case CTRL_PLAYBACK_MODE:
+    case CTRL_REPEAT_FOLDER:
+    case CTRL_RANDOM_ALL:
+        _continuous = true;
+        invalidateMask(PLAYBACK);
+        break;
+    case CTRL_REPEAT_PLAY:
+        _continuous = (param & 0xFF) != 0;
+        invalidateMask(PLAYBACK);
+        break;
+    case CTRL_REPEAT_CURRENT:
+        _continuous = (param & 0xFF) == 0;
+        break;
+
+    // Выбор конкретного трека отменяет повтор
+    case CTRL_SPEC_PLAY:
+    case CTRL_SPEC_FOLDER:
+    case CTRL_SPEC_PLAY_MP3:
+    case CTRL_SPEC_TRACK_3000:
+    case CTRL_STOP:
+        _continuous = false;
+        invalidateMask(PLAYBACK);
+        break;
+
+    case CTRL_NEXT:
+    case CTRL_PREV:
+    case CTRL_SLEEP:
+    case CTRL_PLAY:
+    case CTRL_PAUSE:
+    case CTRL_INSERT_ADVERT:
+    case CTRL_STOP_ADVERT:
+        invalidateMask(PLAYBACK);
+        break;
+
+    // Число папок и треки относятся к текущему носителю
+    case CTRL_PLAYBACK_SRC:
+        invalidateMask(PLAYBACK | (1u << Folders));
+        break;
+    case CTRL_RESET:
+        _continuous = false;
+        invalidateAll();
+        break;
+    default:
+        break;
+    }
+}
+
+void DFPlayerState::messageReceived(quint8 opcode, quint16 value)
+{
+    switch (opcode)
+    {
+    case CMD_STATUS:
+        set(Status, value);
+        break;
+    case CMD_VOLUME:
+        set(Volume, value & 0xFF);
+        break;
+    case CMD_EQ:
+        set(Equalizer, value & 0xFF);
+        break;
+    case CMD_USB_FILES:
+        set(UsbFiles, value);
+        break;
+    case CMD_SD_FILES:
+        set(SdFiles, value);
+        break;
+    case CMD_USB_TRACK:
+        set(UsbTrack, value);
+        break;
+    case CMD_SD_TRACK:
+        set(SdTrack, value);
+        break;
+    case CMD_FOLDERS:
+        set(Folders, value);
+        break;
+
+    case CMD_DEV_PLUGGED:
+        invalidateMask(MEDIA);
+        emit deviceInserted(value & 0xFF);
+        break;
+    case CMD_DEV_PULL_OUT:
+        invalidateMask(MEDIA);
+        emit deviceRemoved(value & 0xFF);
+        break;
+    case CMD_CUR_DEV_ONLINE:
+        _continuous = false;
+        invalidateAll();
+        emit deviceOnline(value & 0xFF);
+        break;
+
+    case CMD_TRACK_FINSH_USB:
+    case CMD_TRACK_FINSH_SD:
+    {
+        // Повтор пришёл бы уже после следующей команды воспроизведения и остановил бы её трек
+        if (isRepeatedFinish(opcode, value))
+            break;
+        _finishOpcode = opcode;
+        _finishValue = value;
+        _finishedAt = MonotonicClock::nowNs();
+
+        // Закончившийся трек остаётся текущим; без повтора модуль останавливается,
+        // в режиме повтора играет следующий трек, номер которого неизвестен
+        const int device = opcode == CMD_TRACK_FINSH_USB ? 1 : 2;
+        const Field track = opcode == CMD_TRACK_FINSH_USB ? UsbTrack : SdTrack;
+        if (_continuous)
+        {
+            set(Status, (device << 8) | 1);
+            invalidate(track);
+        }
+        else
+        {
+            set(Status, device << 8);
+            set(track, value);
+        }
+        emit trackFinished(device, value);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+bool DFPlayerState::isRepeatedFinish(quint8 opcode, quint16 value) const
+{
+    return _finishedAt != 0 && opcode == _finishOpcode && value == _finishValue
+            && MonotonicClock::nowNs() - _finishedAt < FINISH_REPEAT_WINDOW * MonotonicClock::NS_PER_MS;
+}
+
+void DFPlayerState::invalidate(Field field)
+{
+    invalidateMask(bit(field));
+}
+
+void DFPlayerState::invalidateAll()
+{
+    _finishedAt = 0;
+    invalidateMask(ALL);
+}
+
+DFPlayerCommands::Command DFPlayerState::queryOf(Field field)
+{
+    switch (field)
+    {
+    case Status:
+        return DFPlayerCommands::QueryStatus;
+    case Volume:
+        return DFPlayerCommands::QueryVolume;
+    case Equalizer:
+        return DFPlayerCommands::QueryEqualizer;
+    case UsbFiles:
+        return DFPlayerCommands::QueryUsbFiles;
+    case SdFiles:
+        return DFPlayerCommands::QuerySdFiles;
+    case UsbTrack:
+        return DFPlayerCommands::QueryUsbTrack;
+    case SdTrack:
+        return DFPlayerCommands::QuerySdTrack;
+    default:
+        return DFPlayerCommands::QueryFolders;
+    }
+}
+
+quint32 DFPlayerState::bit(Field field)
+{
+    return 1u << field;
+}
+
+void DFPlayerState::set(Field field, int value)
+{
+    if (isValid(field) && _values[field] == value)
+        return;
+
+    _values[field] = value;
+    _valid |= bit(field);
+    emit changed();
+}
+
+void DFPlayerState::invalidateMask(quint32 mask)
+{
+    if (!(_valid & mask))
+        return;
+
+    _valid &= ~mask;
+    emit changed();
+}
@@ -0,0 +1,84 @@
+#ifndef DFPLAYERSTATE_H
+#define DFPLAYERSTATE_H
+
+#include <QObject>
+
+#include "dfplayercommands.h"
+
+// Кэш состояния модуля DFPlayer. Значения приходят из ответов на запросы и сообщений, которые
+// модуль присылает сам (окончание трека, подключение носителя); отправленные команды и сообщения
+// помечают зависящие от них поля устаревшими. Обновлять нужно только устаревшие поля,
+// остальное показывается из кэша без обмена с модулем, опроса нет.
+// Живёт дольше окна DF_Player, чтобы окно сразу показывало известное состояние.
+// Содержимое папок хранит DFPlayerCatalog.
+class DFPlayerState : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Field
+    {
+        Status,     // MSB - носитель, LSB - 0 стоп, 1 воспроизведение, 2 пауза
+        Volume,
+        Equalizer,
+        UsbFiles,
+        SdFiles,
+        UsbTrack,
+        SdTrack,
+        Folders,
+        FIELD_COUNT
+    };
+
+    // Модуль сообщает об окончании трека дважды подряд - повтор в этом окне не обрабатывается
+    static const int FINISH_REPEAT_WINDOW = 1000;
+
+    explicit DFPlayerState(QObject *parent = nullptr);
+
+    bool isValid(Field field) const;
+    // -1, если значение неизвестно или устарело
+    int value(Field field) const;
+    bool isPlaying() const;
+    // Для отображения: "?", если значение неизвестно; состояние - словами
+    QString text(Field field) const;
+    QString statusText() const;
+
+    // Команда записана в порт - применяются правила инвалидации
+    void commandSent(quint8 opcode, quint16 param);
+    // Пакет от модуля: ответ обновляет поле, событие помечает поля устаревшими
+    void messageReceived(quint8 opcode, quint16 value);
+    // Повтор уже обработанного сообщения об окончании трека
+    bool isRepeatedFinish(quint8 opcode, quint16 value) const;
+
+    void invalidate(Field field);
+    // Другое устройство или порт закрыт - ничего из кэша не верно
+    void invalidateAll();
+
+    // Запрос, обновляющий поле
+    static DFPlayerCommands::Command queryOf(Field field);
+
+signals:
+    void changed();
+
+    // Сообщения, которые модуль присылает сам; device: 1 - USB, 2 - SD, 4 - PC
+    void trackFinished(int device, int track);
+    void deviceInserted(int device);
+    void deviceRemoved(int device);
+    // Модуль включился или перезапустился
+    void deviceOnline(int device);
+
+private:
+    static quint32 bit(Field field);
+    void set(Field field, int value);
+    void invalidateMask(quint32 mask);
+
+    int _values[FIELD_COUNT];
+    quint32 _valid = 0;
+    // Включён режим, в котором модуль сам переходит к следующему треку
+    bool _continuous = false;
+    // Последнее обработанное сообщение об окончании трека
+    quint8 _finishOpcode = 0;
+    quint16 _finishValue = 0;
+    qint64 _finishedAt = 0;
+};
+
+#endif // DFPLAYERSTATE_H
@@ -0,0 +1,386 @@
+#include "framesplitter.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const uchar SLIP_END = 0xC0;
+static const uchar SLIP_ESC = 0xDB;
+static const uchar SLIP_ESC_END = 0xDC;
+static const uchar SLIP_ESC_ESC = 0xDD;
+
+static QByteArray encodeCobs(const QByteArray &payload)
+{
+    QByteArray result;
+    result.reserve(payload.size() + payload.size() / 254 + 2);
+
+    int codeIndex = 0;
+    uchar code = 1;
+    result += '\0';
+    for (char ch : payload)
+    {
+        if (ch != 0)
+        {
+            result += ch;
+            ++code;
+        }
+        if (ch == 0 || code == 0xFF)
+        {
+            result[codeIndex] = static_cast<char>(code);
+            codeIndex = result.size();
+            code = 1;
+            result += '\0';
+        }
+    }
+    result[codeIndex] = static_cast<char>(code);
+    result += '\0';
+    return result;
+}
+
+static QByteArray decodeCobs(const QByteArray &frame, bool &ok)
+{
+    QByteArray result;
+    result.reserve(frame.size());
+
+    // Завершающий ноль в данные не входит
+    const int end = frame.endsWith('\0') ? frame.size() - 1 : frame.size();
+    // Пустые кадры перед кадром (лишний ноль в потоке) пропускаются, как при проверке кадра
+    int pos = 0;
+    while (pos < end && frame[pos] == '\0')
+        ++pos;
+    while (pos < end)
+    {
+        const uchar code = static_cast<uchar>(frame[pos]);
+        if (code == 0 || pos + code > end)
+        {
+            ok = false;
+            return result;
+        }
+        result += frame.mid(pos + 1, code - 1);
+        pos += code;
+        if (code != 0xFF && pos < end)
+            result += '\0';
+    }
+    return result;
+}
+
+static QByteArray encodeSlip(const QByteArray &payload)
+{
+    QByteArray result;
+    result.reserve(payload.size() + 2);
+
+    // Начальный END сбрасывает мусор, накопленный приёмником
+    result += static_cast<char>(SLIP_END);
+    for (char ch : payload)
+    {
+        if (static_cast<uchar>(ch) == SLIP_END)
+            result.append(static_cast<char>(SLIP_ESC)).append(static_cast<char>(SLIP_ESC_END));
+        else if (static_cast<uchar>(ch) == SLIP_ESC)
+            result.append(static_cast<char>(SLIP_ESC)).append(static_cast<char>(SLIP_ESC_ESC));
+        else
+            result += ch;
+    }
+    result += static_cast<char>(SLIP_END);
+    return result;
+}
+
+static QByteArray decodeSlip(const QByteArray &frame, bool &ok)
+{
+    QByteArray result;
+    result.reserve(frame.size());
+
+    for (int i = 0; i < frame.size(); ++i)
+    {
+        const uchar ch = static_cast<uchar>(frame[i]);
+        if (ch == SLIP_END)
+            continue;
+        if (ch != SLIP_ESC)
+        {
+            result += static_cast<char>(ch);
+            continue;
+        }
+
+        const uchar code = i + 1 < frame.size() ? static_cast<uchar>(frame[++i]) : 0;
+        if (code == SLIP_ESC_END)
+            result += static_cast<char>(SLIP_END);
+        else if (code == SLIP_ESC_ESC)
+            result += static_cast<char>(SLIP_ESC);
+        else
+            ok = false;
+    }
+    return result;
+}
+
+QByteArray FrameSplitter::encode(const QByteArray &payload, const Settings &settings)
+{
+    switch (settings.mode)
+    {
+    case Delimiter:
+        return payload + settings.delimiter;
+    case FixedLength:
+    {
+        // Последний кадр дополняется нулями
+        const int length = qMax(1, settings.length);
+        const int frames = qMax(1, (payload.size() + length - 1) / length);
+        QByteArray result = payload;
+        result.append(frames * length - payload.size(), '\0');
+        return result;
+    }
+    case LengthPrefix:
+    {
+        // Данные длиннее, чем помещается в префикс, отправляются несколькими кадрами
+        const int maxLength = settings.prefixSize == 2 ? 0xFFFF : 0xFF;
+        QByteArray result;
+        int pos = 0;
+        do
+        {
+            const int length = qMin(maxLength, payload.size() - pos);
+            if (settings.prefixSize == 2)
+                result += static_cast<char>(length >> 8);
+            result += static_cast<char>(length);
+            result += payload.mid(pos, length);
+            pos += length;
+        } while (pos < payload.size());
+        return result;
+    }
+    case Slip:
+        return encodeSlip(payload);
+    case Cobs:
+        return encodeCobs(payload);
+    default:
+        return payload;
+    }
+}
+
+QByteArray FrameSplitter::decode(const QByteArray &frame, const Settings &settings, bool *ok)
+{
+    bool valid = true;
+    QByteArray result;
+    switch (settings.mode)
+    {
+    case Delimiter:
+        result = frame.endsWith(settings.delimiter) ? frame.left(frame.size() - settings.delimiter.size()) : frame;
+        break;
+    case LengthPrefix:
+        result = frame.mid(settings.prefixSize);
+        break;
+    case Slip:
+        result = decodeSlip(frame, valid);
+        break;
+    case Cobs:
+        result = decodeCobs(frame, valid);
+        break;
+    default:
+        result = frame;
+    }
+
+    if (ok)
+        *ok = valid;
+    return result;
+}
+
+void FrameSplitter::setStore(const ByteStore *store)
+{
+    _store = store;
+    reset();
+}
+
+void FrameSplitter::setSettings(const Settings &settings)
+{
+    _settings = settings;
+    _settings.length = qMax(1, _settings.length);
+    _settings.prefixSize = qBound(1, _settings.prefixSize, 2);
+    if (_settings.delimiter.isEmpty())
+        _settings.delimiter = "\n";
+
+    // Новые правила - разбор всей истории заново
+    reset();
+    update();
+}
+
+const FrameSplitter::Settings &FrameSplitter::settings() const
+{
+    return _settings;
+}
+
+void FrameSplitter::update()
+{
+    if (!_store)
+        return;
+
+    switch (_settings.mode)
+    {
+    case Delimiter:
+    case Slip:
+    case Cobs:
+        splitDelimiter();
+        break;
+    case FixedLength:
+        splitFixedLength();
+        break;
+    case LengthPrefix:
+        splitLengthPrefix();
+        break;
+    default:
+        break;
+    }
+}
+
+void FrameSplitter::reset()
+{
+    _frames.clear();
+    _frames.shrink_to_fit();
+    _statistics = Statistics();
+    _frameStart = _scanned = 0;
+    _recordIndex = 0;
+}
+
+const std::vector<ByteStore::Record> &FrameSplitter::frames() const
+{
+    return _frames;
+}
+
+const FrameSplitter::Statistics &FrameSplitter::statistics() const
+{
+    return _statistics;
+}
+
+qint64 FrameSplitter::frameOfOffset(quint64 offset) const
+{
+    auto it = std::upper_bound(_frames.begin(), _frames.end(), offset,
+                               [](quint64 value, const ByteStore::Record &frame) { return value < frame.offset; });
+    if (it == _frames.begin())
+        return -1;
+
+    --it;
+    if (offset >= it->offset + it->length)
+        return -1;
+    return it - _frames.begin();
+}
+
+void FrameSplitter::splitDelimiter()
+{
+    QByteArray delimiter = _settings.delimiter;
+    if (_settings.mode == Slip)
+        delimiter = QByteArray(1, static_cast<char>(SLIP_END));
+    else if (_settings.mode == Cobs)
+        delimiter = QByteArray(1, '\0');
+
+    const quint64 tail = static_cast<quint64>(delimiter.size() - 1);
+    const char last = delimiter.back();
+
+    // Кандидаты - вхождения последнего байта разделителя, остальные байты проверяются назад (в том числе через стык блоков)
+    while (_scanned < _store->size())
+    {
+        size_t available;
+        const char *data = _store->span(_scanned, available);
+        const char *found = static_cast<const char *>(std::memchr(data, last, available));
+        if (!found)
+        {
+            _scanned += available;
+            continue;
+        }
+
+        const quint64 position = _scanned + static_cast<quint64>(found - data);
+        _scanned = position + 1;
+
+        if (position < _frameStart + tail)
+            continue;
+
+        bool matches = true;
+        for (quint64 i = 0; i < tail && matches; ++i)
+            matches = byteAt(position - tail + i) == static_cast<uchar>(delimiter[static_cast<int>(i)]);
+        if (!matches)
+            continue;
+
+        // Одиночный END/0x00 между кадрами не образует кадра и остаётся в начале следующего
+        if (_settings.mode != Delimiter && position == _frameStart)
+            continue;
+        if (_settings.mode == Slip && position == _frameStart + 1 && byteAt(_frameStart) == SLIP_END)
+            continue;
+
+        addFrame(position + 1);
+    }
+}
+
+void FrameSplitter::splitFixedLength()
+{
+    const quint64 length = static_cast<quint64>(_settings.length);
+    while (_store->size() - _frameStart >= length)
+        addFrame(_frameStart + length);
+    _scanned = _store->size();
+}
+
+void FrameSplitter::splitLengthPrefix()
+{
+    const quint64 prefixSize = static_cast<quint64>(_settings.prefixSize);
+    while (_store->size() - _frameStart >= prefixSize)
+    {
+        quint64 length = byteAt(_frameStart);
+        if (prefixSize == 2)
+            length = (length << 8) | byteAt(_frameStart + 1);
+
+        if (_store->size() - _frameStart < prefixSize + length)
+            break;
+        addFrame(_frameStart + prefixSize + length);
+    }
+    _scanned = _store->size();
+}
+
+void FrameSplitter::addFrame(quint64 end)
+{
+    // Время кадра - время порции, в которой пришёл его последний байт
+    const std::vector<ByteStore::Record> &records = _store->records();
+    while (_recordIndex + 1 < records.size() && records[_recordIndex].offset + records[_recordIndex].length < end)
+        ++_recordIndex;
+
+    ByteStore::Record frame;
+    frame.offset = _frameStart;
+    frame.length = static_cast<quint32>(end - _frameStart);
+    frame.timestamp = records.empty() ? 0 : records[_recordIndex].timestamp;
+    _frames.push_back(frame);
+
+    const quint64 length = frame.length;
+    _statistics.minLength = _statistics.frames == 0 ? length : qMin(_statistics.minLength, length);
+    _statistics.maxLength = qMax(_statistics.maxLength, length);
+    _statistics.totalLength += length;
+    ++_statistics.frames;
+    if (!isValid(frame.offset, length))
+        ++_statistics.errors;
+
+    _frameStart = end;
+}
+
+bool FrameSplitter::isValid(quint64 offset, quint64 length) const
+{
+    const quint64 end = offset + length - 1;
+    if (_settings.mode == Cobs)
+    {
+        // Коды COBS должны ровно дойти до завершающего нуля (пустые кадры перед ним пропускаются)
+        quint64 pos = offset;
+        while (pos < end && byteAt(pos) == 0)
+            ++pos;
+        while (pos < end)
+            pos += byteAt(pos);
+        return pos == end;
+    }
+
+    if (_settings.mode == Slip)
+    {
+        for (quint64 pos = offset; pos < end; ++pos)
+        {
+            if (byteAt(pos) != SLIP_ESC)
+                continue;
+            const uchar code = byteAt(++pos);
+            if (code != SLIP_ESC_END && code != SLIP_ESC_ESC)
+                return false;
+        }
+    }
+    return true;
+}
+
+uchar FrameSplitter::byteAt(quint64 offset) const
+{
+    size_t available;
+    const char *data = _store->span(offset, available);
+    return data ? static_cast<uchar>(*data) : 0;
+}
@@ -0,0 +1,84 @@
+#ifndef FRAMESPLITTER_H
+#define FRAMESPLITTER_H
+
+#include <QByteArray>
+
+#include <vector>
+
+#include "bytestore.h"
+
+// Разбиение принятого потока на кадры. Кадр - участок ByteStore (смещение и длина), данные не копируются.
+// Незавершённый кадр переносится между вызовами update() как смещение его начала и состояние разбора.
+// Те же способы кадрирования доступны для отправки (encode).
+class FrameSplitter
+{
+public:
+    enum Mode
+    {
+        None,           // кадры не выделяются, единица - порция, прочитанная из порта
+        Delimiter,      // кадр заканчивается разделителем (разделитель входит в кадр)
+        FixedLength,    // кадры одинаковой длины
+        LengthPrefix,   // 1 или 2 байта длины (big-endian), затем данные
+        Slip,           // RFC 1055: кадр заканчивается END (0xC0), ESC (0xDB) экранирует END и ESC
+        Cobs            // Consistent Overhead Byte Stuffing, кадр заканчивается 0x00
+    };
+
+    struct Settings
+    {
+        Mode mode = None;
+        QByteArray delimiter = "\n";
+        int length = 16;
+        int prefixSize = 1;
+    };
+
+    // Счётчики для строки состояния
+    struct Statistics
+    {
+        quint64 frames = 0;
+        quint64 errors = 0;
+        quint64 minLength = 0;
+        quint64 maxLength = 0;
+        quint64 totalLength = 0;
+    };
+
+    static QByteArray encode(const QByteArray &payload, const Settings &settings);
+    // Данные кадра без служебных байт (SLIP и COBS раскодируются)
+    static QByteArray decode(const QByteArray &frame, const Settings &settings, bool *ok = nullptr);
+
+    void setStore(const ByteStore *store);
+    void setSettings(const Settings &settings);
+    const Settings &settings() const;
+
+    // Разобрать данные, добавленные в хранилище с прошлого вызова
+    void update();
+    // Хранилище очищено
+    void reset();
+
+    const std::vector<ByteStore::Record> &frames() const;
+    const Statistics &statistics() const;
+    // Номер кадра, содержащего offset, -1 если байт ещё не вошёл в кадр
+    qint64 frameOfOffset(quint64 offset) const;
+
+private:
+    void splitDelimiter();
+    void splitFixedLength();
+    void splitLengthPrefix();
+
+    void addFrame(quint64 end);
+    bool isValid(quint64 offset, quint64 length) const;
+    uchar byteAt(quint64 offset) const;
+
+    const ByteStore *_store = nullptr;
+    Settings _settings;
+
+    std::vector<ByteStore::Record> _frames;
+    Statistics _statistics;
+
+    // Начало незавершённого кадра и первая непросмотренная позиция
+    quint64 _frameStart = 0;
+    quint64 _scanned = 0;
+    // Запись хранилища, с которой начинается поиск времени следующего кадра
+    size_t _recordIndex = 0;
+};
+
+#endif // FRAMESPLITTER_H
@@ -0,0 +1,345 @@
+#include "hexcodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEXCODEC_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HEXCODEC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HEXCODEC_TARGET_AVX2
+#endif
+
+namespace
+{
+const char DIGITS[] = "0123456789ABCDEF";
+
+struct DecodeTable
+{
+    int8_t value[256];
+
+    DecodeTable()
+    {
+        for (int i = 0; i < 256; ++i)
+            value[i] = -1;
+        for (int i = 0; i < 10; ++i)
+            value['0' + i] = static_cast<int8_t>(i);
+        for (int i = 0; i < 6; ++i)
+        {
+            value['A' + i] = static_cast<int8_t>(10 + i);
+            value['a' + i] = static_cast<int8_t>(10 + i);
+        }
+    }
+};
+
+const DecodeTable decodeTable;
+
+// Кодирует байты [first, size). Векторные блоки уже записали разделитель после себя,
+// поэтому он ставится только между байтами этого участка.
+void encodeScalar(const uint8_t *src, size_t first, size_t size, char *dst, char separator)
+{
+    for (size_t i = first; i < size; ++i)
+    {
+        if (separator && i > first)
+            *dst++ = separator;
+        *dst++ = DIGITS[src[i] >> 4];
+        *dst++ = DIGITS[src[i] & 0x0F];
+    }
+}
+
+#ifdef HEXCODEC_X86
+
+bool hasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+const bool useAvx2 = hasAvx2();
+
+// Таблицы перестановки для вставки разделителя: 16 байт -> 48 символов "HL:"
+struct SeparatorShuffle
+{
+    alignas(16) int8_t fromLow[3][16];
+    alignas(16) int8_t fromHigh[3][16];
+    alignas(16) int8_t separator[3][16];
+
+    SeparatorShuffle()
+    {
+        for (int o = 0; o < 48; ++o)
+        {
+            const int part = o / 16, j = o % 16;
+            const int byte = o / 3, r = o % 3;
+            fromLow[part][j] = fromHigh[part][j] = -128;
+            separator[part][j] = 0;
+            if (r == 2)
+                separator[part][j] = -1;
+            else if (byte < 8)
+                fromLow[part][j] = static_cast<int8_t>(byte * 2 + r);
+            else
+                fromHigh[part][j] = static_cast<int8_t>((byte - 8) * 2 + r);
+        }
+    }
+};
+
+const SeparatorShuffle separatorShuffle;
+
+inline __m128i nibblesToAscii(__m128i n)
+{
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+
+size_t encodeSse2(const uint8_t *src, size_t size, char *&dst, char separator)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+
+    // С разделителем последний байт блока тоже получает разделитель, поэтому блок не может быть последним
+    for (; separator ? i + 16 < size : i + 16 <= size; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = nibblesToAscii(_mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        const __m128i lo = nibblesToAscii(_mm_and_si128(x, mask));
+        const __m128i first = _mm_unpacklo_epi8(hi, lo);
+        const __m128i second = _mm_unpackhi_epi8(hi, lo);
+
+        if (!separator)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), first);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), second);
+            dst += 32;
+            continue;
+        }
+
+        alignas(16) char pairs[32];
+        _mm_store_si128(reinterpret_cast<__m128i *>(pairs), first);
+        _mm_store_si128(reinterpret_cast<__m128i *>(pairs + 16), second);
+        for (int k = 0; k < 16; ++k)
+        {
+            dst[0] = pairs[2 * k];
+            dst[1] = pairs[2 * k + 1];
+            dst[2] = separator;
+            dst += 3;
+        }
+    }
+    return i;
+}
+
+HEXCODEC_TARGET_AVX2
+size_t encodeAvx2(const uint8_t *src, size_t size, char *&dst, char separator)
+{
+    size_t i = 0;
+
+    if (!separator)
+    {
+        const __m256i mask = _mm256_set1_epi8(0x0F);
+        const __m256i nine = _mm256_set1_epi8(9);
+        const __m256i zero = _mm256_set1_epi8('0');
+        const __m256i letter = _mm256_set1_epi8('A' - '0' - 10);
+
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), mask);
+            __m256i lo = _mm256_and_si256(x, mask);
+            hi = _mm256_add_epi8(_mm256_add_epi8(hi, zero), _mm256_and_si256(_mm256_cmpgt_epi8(hi, nine), letter));
+            lo = _mm256_add_epi8(_mm256_add_epi8(lo, zero), _mm256_and_si256(_mm256_cmpgt_epi8(lo, nine), letter));
+
+            const __m256i p0 = _mm256_unpacklo_epi8(hi, lo);
+            const __m256i p1 = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(p0, p1, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(p0, p1, 0x31));
+            dst += 64;
+        }
+        return i;
+    }
+
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i sep = _mm_set1_epi8(separator);
+    for (; i + 16 < size; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = nibblesToAscii(_mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        const __m128i lo = nibblesToAscii(_mm_and_si128(x, mask));
+        const __m128i first = _mm_unpacklo_epi8(hi, lo);
+        const __m128i second = _mm_unpackhi_epi8(hi, lo);
+
+        for (int part = 0; part < 3; ++part)
+        {
+            const __m128i a = _mm_shuffle_epi8(first, _mm_load_si128(reinterpret_cast<const __m128i *>(separatorShuffle.fromLow[part])));
+            const __m128i b = _mm_shuffle_epi8(second, _mm_load_si128(reinterpret_cast<const __m128i *>(separatorShuffle.fromHigh[part])));
+            const __m128i s = _mm_and_si128(sep, _mm_load_si128(reinterpret_cast<const __m128i *>(separatorShuffle.separator[part])));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + part * 16), _mm_or_si128(_mm_or_si128(a, b), s));
+        }
+        dst += 48;
+    }
+    return i;
+}
+
+// 16 символов -> 16 тетрад; false, если встретился не шестнадцатеричный символ
+inline bool asciiToNibbles(__m128i c, __m128i &n)
+{
+    const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)), _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+    const __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)), _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+
+    n = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    return _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xFFFF;
+}
+
+// Пары тетрад (старшая в младшем байте слова) -> байты в младших байтах слов
+inline __m128i packNibbles(__m128i n)
+{
+    return _mm_or_si128(_mm_and_si128(_mm_slli_epi16(n, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(n, 8));
+}
+
+size_t decodeSse2(const char *src, size_t size, uint8_t *&dst)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m128i n0, n1;
+        if (!asciiToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), n0)
+                || !asciiToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 16)), n1))
+            break;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(packNibbles(n0), packNibbles(n1)));
+        dst += 16;
+    }
+    return i;
+}
+
+HEXCODEC_TARGET_AVX2
+inline bool asciiToNibblesAvx2(__m256i c, __m256i &n)
+{
+    const __m256i minusOne = _mm256_set1_epi8(-1);
+    const __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    const __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(digit, minusOne), _mm256_cmpgt_epi8(_mm256_set1_epi8(10), digit));
+    const __m256i letter = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i isLetter = _mm256_and_si256(_mm256_cmpgt_epi8(letter, minusOne), _mm256_cmpgt_epi8(_mm256_set1_epi8(6), letter));
+
+    n = _mm256_or_si256(_mm256_and_si256(isDigit, digit), _mm256_and_si256(isLetter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+    return _mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter)) == -1;
+}
+
+HEXCODEC_TARGET_AVX2
+inline __m256i packNibblesAvx2(__m256i n)
+{
+    return _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(n, 4), _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(n, 8));
+}
+
+HEXCODEC_TARGET_AVX2
+size_t decodeAvx2(const char *src, size_t size, uint8_t *&dst)
+{
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m256i n0, n1;
+        if (!asciiToNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)), n0)
+                || !asciiToNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32)), n1))
+            break;
+
+        // packus работает внутри 128-битных половин, порядок восстанавливается перестановкой
+        const __m256i packed = _mm256_packus_epi16(packNibblesAvx2(n0), packNibblesAvx2(n1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute4x64_epi64(packed, 0xD8));
+        dst += 32;
+    }
+    return i;
+}
+
+#endif // HEXCODEC_X86
+}
+
+namespace HexCodec
+{
+size_t encodedLength(size_t size, char separator)
+{
+    if (size == 0)
+        return 0;
+
+    return separator ? size * 3 - 1 : size * 2;
+}
+
+void encode(const uint8_t *src, size_t size, char *dst, char separator)
+{
+    size_t done = 0;
+#ifdef HEXCODEC_X86
+    done = useAvx2 ? encodeAvx2(src, size, dst, separator) : encodeSse2(src, size, dst, separator);
+#endif
+    encodeScalar(src, done, size, dst, separator);
+}
+
+size_t decode(const char *src, size_t size, uint8_t *dst)
+{
+    uint8_t *out = dst;
+    int pending = -1;
+    size_t i = 0;
+
+    while (i < size)
+    {
+#ifdef HEXCODEC_X86
+        // Векторный путь только для непрерывных цифр, когда нет незавершённого байта
+        if (pending < 0)
+            i += useAvx2 ? decodeAvx2(src + i, size - i, out) : decodeSse2(src + i, size - i, out);
+#endif
+        const size_t end = size - i > 32 ? i + 32 : size;
+        for (; i < end; ++i)
+        {
+            const int value = decodeTable.value[static_cast<uint8_t>(src[i])];
+            if (value < 0)
+                continue;
+
+            if (pending < 0)
+                pending = value;
+            else
+            {
+                *out++ = static_cast<uint8_t>((pending << 4) | value);
+                pending = -1;
+            }
+        }
+    }
+
+    if (pending >= 0)
+        *out++ = static_cast<uint8_t>(pending);
+
+    return static_cast<size_t>(out - dst);
+}
+
+QString toHex(const QByteArray &data, char separator)
+{
+    const size_t size = static_cast<size_t>(data.size());
+    QByteArray result(static_cast<int>(encodedLength(size, separator)), Qt::Uninitialized);
+    encode(reinterpret_cast<const uint8_t *>(data.constData()), size, result.data(), separator);
+    return QString::fromLatin1(result);
+}
+
+QByteArray fromHex(const QString &text)
+{
+    const QByteArray latin = text.toLatin1();
+    QByteArray result(latin.size() / 2 + 1, Qt::Uninitialized);
+    result.resize(static_cast<int>(decode(latin.constData(), static_cast<size_t>(latin.size()),
+                                          reinterpret_cast<uint8_t *>(result.data()))));
+    return result;
+}
+}
@@ -0,0 +1,30 @@
+#ifndef HEXCODEC_H
+#define HEXCODEC_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+
+// Преобразование байт <-> шестнадцатеричный текст для целых буферов.
+// На x86 используется SSE2 или AVX2 (выбор при запуске), иначе скалярный вариант.
+namespace HexCodec
+{
+// Длина текста для size байт; separator == 0 - без разделителя
+size_t encodedLength(size_t size, char separator = 0);
+
+// Кодирование в верхнем регистре, между байтами вставляется separator (если не 0).
+// В dst должно быть encodedLength(size, separator) символов.
+void encode(const uint8_t *src, size_t size, char *dst, char separator = 0);
+
+// Декодирование: символы, не являющиеся шестнадцатеричными цифрами (разделители, пробелы,
+// переводы строк), пропускаются. Одиночная последняя цифра считается младшей тетрадой байта.
+// В dst должно быть не меньше size / 2 + 1 байт. Возвращает количество записанных байт.
+size_t decode(const char *src, size_t size, uint8_t *dst);
+
+QString toHex(const QByteArray &data, char separator = 0);
+QByteArray fromHex(const QString &text);
+}
+
+#endif // HEXCODEC_H
@@ -1,5 +1,16 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "hexcodec.h"
+#include "monotonicclock.h"
+
+#include <QActionGroup>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QShortcut>
+
+// Сколько данных из файла записи загружается в окно приёма
+static const quint64 CAPTURE_LOAD_LIMIT = 64 * 1024 * 1024;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -7,6 +18,75 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     ui->statusBar->addWidget(&_statusLabel);
+    ui->statusBar->addPermanentWidget(&_frameStatusLabel);
+
+    ui->inData->setMode(ByteView::Ascii);
+    ui->inData->setStore(&_rxStore);
+    ui->inDataRaw->setMode(ByteView::Hex);
+    ui->inDataRaw->setStore(&_rxStore);
+
+    QActionGroup *frameRateGroup = new QActionGroup(this);
+    frameRateGroup->addAction(ui->actionFrameRate30);
+    frameRateGroup->addAction(ui->actionFrameRate60);
+    connect(ui->actionFrameRate30, &QAction::triggered, this, [this]() { _presentation.setFrameRate(30); });
+    connect(ui->actionFrameRate60, &QAction::triggered, this, [this]() { _presentation.setFrameRate(60); });
+    connect(&_presentation, &PresentationScheduler::present, this, &MainWindow::presentIncoming);
+
+    QActionGroup *timeFormatGroup = new QActionGroup(this);
+    timeFormatGroup->addAction(ui->actionTimeAbsolute);
+    timeFormatGroup->addAction(ui->actionTimeRelative);
+    timeFormatGroup->addAction(ui->actionTimeDelta);
+    const std::pair<QAction *, ByteView::TimeFormat> timeFormats[] = {
+        {ui->actionTimeAbsolute, ByteView::AbsoluteTime},
+        {ui->actionTimeRelative, ByteView::RelativeTime},
+        {ui->actionTimeDelta, ByteView::DeltaTime}
+    };
+    for (const auto &timeFormat : timeFormats)
+    {
+        const ByteView::TimeFormat format = timeFormat.second;
+        connect(timeFormat.first, &QAction::triggered, this, [this, format]() {
+            ui->inData->setTimeFormat(format);
+            ui->inDataRaw->setTimeFormat(format);
+        });
+    }
+
+    _framer.setStore(&_rxStore);
+    QActionGroup *framingGroup = new QActionGroup(this);
+    const std::pair<QAction *, FrameSplitter::Mode> framings[] = {
+        {ui->actionFrameNone, FrameSplitter::None},
+        {ui->actionFrameDelimiter, FrameSplitter::Delimiter},
+        {ui->actionFrameFixed, FrameSplitter::FixedLength},
+        {ui->actionFrameLength, FrameSplitter::LengthPrefix},
+        {ui->actionFrameSlip, FrameSplitter::Slip},
+        {ui->actionFrameCobs, FrameSplitter::Cobs}
+    };
+    for (const auto &framing : framings)
+    {
+        const FrameSplitter::Mode mode = framing.second;
+        framingGroup->addAction(framing.first);
+        connect(framing.first, &QAction::triggered, this, [this, mode]() { setFraming(mode); });
+    }
+
+    // Пункты меню декодеров строятся по списку доступных
+    QActionGroup *decoderGroup = new QActionGroup(this);
+    const QStringList decoders = QStringList() << QString() << ProtocolDecoder::available();
+    for (const QString &name : decoders)
+    {
+        QAction *action = ui->menuDecoder->addAction(name.isEmpty() ? tr("Нет") : name);
+        action->setCheckable(true);
+        action->setChecked(name.isEmpty());
+        decoderGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, name]() { setDecoder(name); });
+    }
+
+    _search.setStore(&_rxStore);
+    connect(ui->searchText, &QLineEdit::textChanged, this, &MainWindow::searchChanged);
+    connect(ui->searchMode, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::searchChanged);
+    connect(ui->searchText, &QLineEdit::returnPressed, this, &MainWindow::on_searchNext_clicked);
+    connect(new QShortcut(QKeySequence::Find, this), &QShortcut::activated, this, [this]() {
+        ui->searchText->setFocus();
+        ui->searchText->selectAll();
+    });
 
     ui->endString->addItem(QStringLiteral("нет"), "");
     ui->endString->addItem(QStringLiteral("\\n"), "\n");
@@ -15,8 +95,15 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->outData, &QPlainTextEdit::textChanged, this, &MainWindow::outDataTextChanged);
     connect(ui->sendData, &QPushButton::clicked, this, &MainWindow::write);
 
-    connect(&_serialport, &QSerialPort::errorOccurred, this, &MainWindow::handleError);
-    connect(&_serialport, &QSerialPort::readyRead, this, &MainWindow::readData);
+    // Окно терминала получает данные первым, запись сеанса - следом, по той же порции
+    _dispatcher.subscribe(this);
+    _dispatcher.subscribe(&_capture);
+    // Сообщение об ошибке - вне раздачи порции подписчикам
+    connect(&_capture, &CaptureWriter::failed, this, [this]() {
+        ui->actionCapture->setChecked(false);
+        QMessageBox::critical(this, tr("Error"), _capture.errorString());
+    }, Qt::QueuedConnection);
+    connect(&_dispatcher, &PortDispatcher::errorOccurred, this, &MainWindow::handleError);
 
     ui->outData->installEventFilter(this);
 
@@ -25,6 +112,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Панель ссылается на порт и состояние DFPlayer - удаляется раньше них
+    delete _dfPlayerDock;
+    delete _dfPlayerFleetDock;
+    _dispatcher.close();
     delete ui;
 }
 
@@ -49,27 +140,52 @@ void MainWindow::on_actionUART_triggered()
 void MainWindow::on_actionConnect_triggered()
 {
     const SettingsDialog::Settings p = _settingDialog.settings();
-    _serialport.setPortName(p.name);
-    _serialport.setBaudRate(p.baudRate);
-    _serialport.setDataBits(p.dataBits);
-    _serialport.setParity(p.parity);
-    _serialport.setStopBits(p.stopBits);
-    _serialport.setFlowControl(p.flowControl);
-
-    if (_serialport.open(QIODevice::ReadWrite))
+
+    QString error;
+    if (openPort(p, ui->actionThreadedRead->isChecked(), error))
     {
-        disableAction(false);
         showStatusMessage(tr("Connected to %1 : %2, %3, %4, %5, %6")
                           .arg(p.name).arg(p.stringBaudRate).arg(p.stringDataBits)
                           .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl));
     }
     else
     {
-        QMessageBox::critical(this, tr("Error"), _serialport.errorString());
+        QMessageBox::critical(this, tr("Error"), error);
         showStatusMessage(tr("Open error"));
     }
 }
 
+bool MainWindow::openPort(const SettingsDialog::Settings &settings, bool threaded, QString &error)
+{
+    ui->actionThreadedRead->setChecked(threaded);
+
+    const bool opened = _dispatcher.open(settings, threaded, error);
+    if (opened)
+    {
+        // Приём с порта не смешивается с открытой записью: у неё другая привязка часов
+        if (_captureLoaded)
+            on_clear_clicked();
+        setByteDuration(SettingsDialog::byteDurationNs(settings));
+        disableAction(false);
+    }
+    return opened;
+}
+
+void MainWindow::closePort()
+{
+    on_actionDisconnect_triggered();
+}
+
+quint64 MainWindow::receivedBytes() const
+{
+    return _rxStore.size();
+}
+
+quint64 MainWindow::droppedBytes() const
+{
+    return _dispatcher.droppedBytes();
+}
+
 void MainWindow::showStatusMessage(const QString &message)
 {
     _statusLabel.setText(message);
@@ -77,8 +193,10 @@ void MainWindow::showStatusMessage(const QString &message)
 
 void MainWindow::on_actionDisconnect_triggered()
 {
-    if (_serialport.isOpen())
-        _serialport.close();
+    _dispatcher.close();
+
+    // После переподключения на порту может быть другой модуль
+    _dfPlayerState.invalidateAll();
 
     disableAction(true);
 
@@ -110,20 +228,10 @@ bool MainWindow::eventFilter(QObject *watched, QEvent *event)
     }
 }
 
-QString MainWindow::byteToHexString(uint8_t ch) const
+QByteArray MainWindow::textToBytes(const QString &str) const
 {
-    QString byte = QString::number(ch, 16);
-    if (ch < 0x10)
-        byte = '0' + byte;
-
-    return byte.toUpper();
-}
-
-QString MainWindow::textToHexText(const QString &str, QString delim) const
-{
-    QString result;
-
     QByteArray rawData;
+    rawData.reserve(str.length());
 
     for (int i = 0; i < str.length(); ++i)
     {
@@ -133,34 +241,7 @@ QString MainWindow::textToHexText(const QString &str, QString delim) const
         rawData.push_back(str[i].unicode());
     }
 
-    for (int i = 0; i < rawData.length(); ++i)
-    {
-        result += byteToHexString(rawData[i]);
-        if ((i != (rawData.length() - 1)))
-            result += delim;
-    }
-    return result;
-}
-
-QString MainWindow::hexTextToText(const QString &str) const
-{
-    QString result, byte;
-    for (const auto &el : str)
-    {
-        byte += el;
-        if (byte.size() == 2)
-        {
-            bool ok;
-            int code = byte.toInt(&ok, 16);
-            if (ok)
-            {
-                result += QChar(code);
-                byte.clear();
-            }
-        }
-    }
-
-    return result;
+    return rawData;
 }
 
 void MainWindow::disableAction(bool state)
@@ -170,39 +251,34 @@ void MainWindow::disableAction(bool state)
     ui->outData->setEnabled(!state);
     ui->sendData->setEnabled(!state);
     ui->actionDisconnect->setEnabled(!state);
+    ui->actionThreadedRead->setEnabled(state);
+    ui->actionOpenCapture->setEnabled(state);
 }
 
 void MainWindow::outDataTextChanged()
 {
-    QString result;
-
+    QByteArray data;
     if (ui->hex->isChecked())
     {
-        QString rawString = ui->outData->toPlainText().remove('\n').remove(' ');
-
-        // Добавить в старший разряд 0 для полного байта
-        if (rawString.length() % 2 > 0)
-            rawString.insert(rawString.length() - 1, '0');
+        // Одиночная последняя цифра считается младшим разрядом полного байта
+        data = HexCodec::fromHex(ui->outData->toPlainText());
 
         // конец строки
-        QByteArray endString = ui->endString->currentData().toString().toLatin1();
-        for( int i = 0; i < endString.length(); ++i)
-            rawString += byteToHexString(endString[i]);
-
-        // вставка двоеточий
-        for (int i = 0; i < rawString.length(); ++i)
-        {
-            result += rawString[i];
-            if ((i % 2 == 1) && (i != (rawString.length() - 1)))
-                result += ':';
-        }
-        ui->outDataRaw->setPlainText(result.toUpper());
+        data += ui->endString->currentData().toString().toLatin1();
     }
     else if (ui->ascii->isChecked())
     {
         QString str = ui->outData->toPlainText() + ui->endString->currentData().toString();
-        ui->outDataRaw->setPlainText(textToHexText(str, ":"));
+        data = textToBytes(str);
     }
+    else
+        return;
+
+    // Отправляемые данные оформляются в кадр по тем же правилам, что и разбор приёма
+    if (ui->actionFrameTx->isChecked())
+        data = FrameSplitter::encode(data, _framer.settings());
+
+    ui->outDataRaw->setPlainText(HexCodec::toHex(data, ':'));
 }
 
 void MainWindow::on_endString_currentIndexChanged(int index)
@@ -214,66 +290,359 @@ void MainWindow::on_endString_currentIndexChanged(int index)
 
 void MainWindow::write()
 {
-    QByteArray dataSend;
-    for (const auto &byte : ui->outDataRaw->toPlainText().split(':'))
+    send(HexCodec::fromHex(ui->outDataRaw->toPlainText()));
+}
+
+void MainWindow::send(const QByteArray &dataSend)
+{
+    // Запись сеанса получает отправленное от диспетчера
+    _dispatcher.write(dataSend);
+}
+
+void MainWindow::portReceived(const QByteArray &data, qint64 timestamp)
+{
+    _rxStore.append(data.constData(), static_cast<size_t>(data.size()), timestamp);
+
+    // Панели обновляются не чаще одного раза за кадр
+    _presentation.schedule();
+}
+
+void MainWindow::presentIncoming()
+{
+    // Незавершённый кадр дописывается при следующих порциях
+    if (_framer.settings().mode != FrameSplitter::None)
+    {
+        _framer.update();
+        updateFrameStatus();
+    }
+
+    if (_decoder)
+        _decoder->update();
+
+    ui->inData->updateContents();
+    ui->inDataRaw->updateContents();
+
+    // Поиск продолжается только по новым байтам
+    if (!_search.pattern().isEmpty())
+    {
+        _search.update();
+        updateSearchStatus();
+    }
+
+    emit incomingPresented(_rxStore.size());
+}
+
+void MainWindow::searchChanged()
+{
+    _search.setPattern(ByteSearch::parsePattern(ui->searchText->text(),
+                                                static_cast<ByteSearch::Mode>(ui->searchMode->currentIndex())));
+    _search.update();
+    _searchHit = -1;
+
+    ui->inData->setHighlight(0, 0);
+    ui->inDataRaw->setHighlight(0, 0);
+    updateSearchStatus();
+}
+
+void MainWindow::on_searchNext_clicked()
+{
+    if (_search.hits().empty())
+        return;
+
+    const qint64 hit = _searchHit < 0 ? 0 : _search.nextHit(_search.hits()[static_cast<size_t>(_searchHit)]);
+    showSearchHit(hit < 0 ? 0 : hit);
+}
+
+void MainWindow::on_searchPrev_clicked()
+{
+    if (_search.hits().empty())
+        return;
+
+    const qint64 last = static_cast<qint64>(_search.hits().size()) - 1;
+    const qint64 hit = _searchHit < 0 ? last : _search.previousHit(_search.hits()[static_cast<size_t>(_searchHit)]);
+    showSearchHit(hit < 0 ? last : hit);
+}
+
+void MainWindow::showSearchHit(qint64 hit)
+{
+    _searchHit = hit;
+
+    const quint64 offset = _search.hits()[static_cast<size_t>(hit)];
+    const quint64 length = static_cast<quint64>(_search.pattern().size());
+    for (ByteView *view : {ui->inData, ui->inDataRaw})
     {
-        dataSend.append(byte.toInt(nullptr, 16));
+        view->setHighlight(offset, length);
+        view->scrollToOffset(offset);
     }
-    _serialport.write(dataSend);
+    updateSearchStatus();
 }
 
-void MainWindow::readData()
+void MainWindow::updateSearchStatus()
 {
-//    _serialport.waitForReadyRead(500);
-    QByteArray data = _serialport.readAll();
-    QString timeMarker = QTime::currentTime().toString("hh:mm:ss.z") + " -> ";
-    ui->inData->appendPlainText(timeMarker + data);
+    if (_search.pattern().isEmpty())
+        ui->searchStatus->clear();
+    else if (_search.hits().empty())
+        ui->searchStatus->setText(tr("Не найдено"));
+    else if (_searchHit < 0)
+        ui->searchStatus->setText(tr("Найдено: %1").arg(_search.hits().size()));
+    else
+    {
+        QString status = tr("%1 из %2").arg(_searchHit + 1).arg(_search.hits().size());
+        const qint64 frame = _framer.settings().mode == FrameSplitter::None
+                ? -1 : _framer.frameOfOffset(_search.hits()[static_cast<size_t>(_searchHit)]);
+        if (frame >= 0)
+            status += tr(", кадр %1").arg(frame + 1);
+        ui->searchStatus->setText(status);
+    }
+}
+
+void MainWindow::setFraming(FrameSplitter::Mode mode)
+{
+    FrameSplitter::Settings settings = _framer.settings();
+    const FrameSplitter::Mode previous = settings.mode;
+    settings.mode = mode;
+
+    bool ok = true;
+    if (mode == FrameSplitter::Delimiter)
+    {
+        // Разделитель задаётся как образец поиска: \n \r \t \0 \xHH
+        const QString text = QInputDialog::getText(this, tr("Кадры"), tr("Разделитель (\\n, \\r, \\xHH):"),
+                                                   QLineEdit::Normal, QStringLiteral("\\n"), &ok);
+        settings.delimiter = ByteSearch::parsePattern(text, ByteSearch::Escaped);
+        ok = ok && !settings.delimiter.isEmpty();
+    }
+    else if (mode == FrameSplitter::FixedLength)
+        settings.length = QInputDialog::getInt(this, tr("Кадры"), tr("Длина кадра, байт:"), settings.length, 1, 65536, 1, &ok);
+    else if (mode == FrameSplitter::LengthPrefix)
+    {
+        const QStringList sizes = {tr("1 байт"), tr("2 байта (старший первым)")};
+        const QString size = QInputDialog::getItem(this, tr("Кадры"), tr("Префикс длины:"), sizes,
+                                                   settings.prefixSize - 1, false, &ok);
+        settings.prefixSize = sizes.indexOf(size) + 1;
+    }
 
-    QString result;
-    for (int i = 0; i < data.length(); ++i)
+    if (!ok)
     {
-        result += byteToHexString(data[i]);;
-        if ((i != (data.length() - 1)))
-            result += ':';
+        // Отмена - остаётся прежнее разбиение
+        const std::pair<FrameSplitter::Mode, QAction *> actions[] = {
+            {FrameSplitter::None, ui->actionFrameNone},
+            {FrameSplitter::Delimiter, ui->actionFrameDelimiter},
+            {FrameSplitter::FixedLength, ui->actionFrameFixed},
+            {FrameSplitter::LengthPrefix, ui->actionFrameLength},
+            {FrameSplitter::Slip, ui->actionFrameSlip},
+            {FrameSplitter::Cobs, ui->actionFrameCobs}
+        };
+        for (const auto &action : actions)
+            action.second->setChecked(action.first == previous);
+        return;
     }
-    ui->inDataRaw->appendPlainText(timeMarker + result.toUpper());
+
+    _framer.setSettings(settings);
+
+    const std::vector<ByteStore::Record> *frames = mode == FrameSplitter::None ? nullptr : &_framer.frames();
+    ui->inData->setSegments(frames);
+    ui->inDataRaw->setSegments(frames);
+
+    updateFrameStatus();
+    updateSearchStatus();
+    outDataTextChanged();
+}
+
+void MainWindow::setDecoder(const QString &name)
+{
+    ui->inData->setDecoder(nullptr);
+    ui->inDataRaw->setDecoder(nullptr);
+
+    // Новый декодер разбирает всю историю
+    _decoder = ProtocolDecoder::create(name);
+    if (_decoder)
+    {
+        _decoder->setStore(&_rxStore);
+        _decoder->update();
+    }
+
+    ui->inData->setDecoder(_decoder.get());
+    ui->inDataRaw->setDecoder(_decoder.get());
 }
-void MainWindow::handleError(QSerialPort::SerialPortError error)
+
+void MainWindow::updateFrameStatus()
+{
+    if (_framer.settings().mode == FrameSplitter::None)
+    {
+        _frameStatusLabel.clear();
+        return;
+    }
+
+    const FrameSplitter::Statistics &statistics = _framer.statistics();
+    QString status = tr("Кадров: %1").arg(statistics.frames);
+    if (statistics.frames > 0)
+        status += tr(", длина %1..%2 (средняя %3)").arg(statistics.minLength).arg(statistics.maxLength)
+                .arg(statistics.totalLength / statistics.frames);
+    if (statistics.errors > 0)
+        status += tr(", ошибок: %1").arg(statistics.errors);
+    _frameStatusLabel.setText(status);
+}
+
+void MainWindow::on_actionFrameTx_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    outDataTextChanged();
+}
+void MainWindow::handleError(QSerialPort::SerialPortError error, const QString &errorString)
 {
     if (error == QSerialPort::ResourceError)
     {
-        QMessageBox::critical(this, tr("Critical Error"), _serialport.errorString());
+        QMessageBox::critical(this, tr("Critical Error"), errorString);
         on_actionDisconnect_triggered();
     }
 }
 
 void MainWindow::on_clear_clicked()
 {
-    ui->inData->clear();
-    ui->inDataRaw->clear();
+    _rxStore.clear();
+    _captureLoaded = false;
+    _framer.reset();
+    updateFrameStatus();
+    if (_decoder)
+        _decoder->reset();
+    ui->inData->reset();
+    ui->inDataRaw->reset();
+
+    _search.reset();
+    _searchHit = -1;
+    updateSearchStatus();
 }
 
 
 void MainWindow::on_hex_toggled(bool checked)
 {
     if (checked)
-        ui->outData->setPlainText(textToHexText(ui->outData->toPlainText()));
+        ui->outData->setPlainText(HexCodec::toHex(textToBytes(ui->outData->toPlainText())));
 }
 
 void MainWindow::on_ascii_toggled(bool checked)
 {
     if (checked)
-        ui->outData->setPlainText(hexTextToText(ui->outData->toPlainText()));
+        ui->outData->setPlainText(QString::fromLatin1(HexCodec::fromHex(ui->outData->toPlainText())));
 }
 
 void MainWindow::on_actionDF_Player_triggered()
 {
-    disconnect(&_serialport, &QSerialPort::readyRead, this, &MainWindow::readData);
+    // Панель не модальная: терминал и запись сеанса продолжают получать данные порта
+    if (!_dfPlayerDock)
+    {
+        _dfPlayerDock = new QDockWidget(tr("DF Player"), this);
+        _dfPlayerDock->setObjectName(QStringLiteral("dfPlayerDock"));
+        _dfPlayerDock->setWidget(new DF_Player(_dispatcher, _dfPlayerState, _dfPlayerCatalog, _protocolLog,
+                                               _dfPlayerDock));
+        addDockWidget(Qt::RightDockWidgetArea, _dfPlayerDock);
+    }
+
+    _dfPlayerDock->show();
+    _dfPlayerDock->raise();
+}
+
+void MainWindow::on_actionDF_Player_Fleet_triggered()
+{
+    if (!_dfPlayerFleetDock)
+    {
+        _dfPlayerFleetDock = new QDockWidget(tr("Парк DF Player"), this);
+        _dfPlayerFleetDock->setObjectName(QStringLiteral("dfPlayerFleetDock"));
+        _dfPlayerFleetDock->setWidget(new DFPlayerFleetPanel(_settingDialog, _dfPlayerFleetDock));
+        addDockWidget(Qt::BottomDockWidgetArea, _dfPlayerFleetDock);
+    }
+
+    _dfPlayerFleetDock->show();
+    _dfPlayerFleetDock->raise();
+}
+
+void MainWindow::on_actionCapture_toggled(bool checked)
+{
+    if (!checked)
+    {
+        if (!_capture.close())
+            QMessageBox::critical(this, tr("Error"), _capture.errorString());
+        return;
+    }
+
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Записать сеанс"), QString(),
+                                                          tr("Запись сеанса (*.uartcap)"));
+    if (fileName.isEmpty() || !_capture.open(fileName, _settingDialog.settings(), MonotonicClock::nowNs()))
+    {
+        if (!fileName.isEmpty())
+            QMessageBox::critical(this, tr("Error"), _capture.errorString());
+        ui->actionCapture->setChecked(false);
+    }
+}
+
+void MainWindow::on_actionOpenCapture_triggered()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Открыть запись"), QString(),
+                                                          tr("Запись сеанса (*.uartcap)"));
+    if (fileName.isEmpty())
+        return;
+
+    CaptureReader reader;
+    if (!reader.open(fileName))
+    {
+        QMessageBox::critical(this, tr("Error"), reader.errorString());
+        return;
+    }
+
+    const CaptureFile::Header &header = reader.header();
+    const qint64 duration = (reader.lastTimestamp() - reader.firstTimestamp()) / 1000000000;
+
+    // Начальный момент задаётся относительно начала записи (часы не ограничены сутками),
+    // переход к нему - по индексу файла
+    bool ok;
+    const QString start = QInputDialog::getText(this, tr("Открыть запись"),
+                                                tr("Начать с (чч:мм:сс, длительность %1:%2:%3):")
+                                                .arg(duration / 3600, 2, 10, QChar('0'))
+                                                .arg(duration / 60 % 60, 2, 10, QChar('0'))
+                                                .arg(duration % 60, 2, 10, QChar('0')),
+                                                QLineEdit::Normal, QStringLiteral("00:00:00"), &ok);
+    if (!ok)
+        return;
+
+    qint64 startOffsetNs = 0;
+    for (const QString &part : start.split(':'))
+        startOffsetNs = startOffsetNs * 60 + part.toLongLong();
+    startOffsetNs *= 1000000000LL;
+
+    on_clear_clicked();
+    // Отметки в файле - монотонные часы записавшего процесса, перевод в системное время - по заголовку
+    _rxStore.setClockAnchor(header.startMonotonicNs, header.startWallClockMs);
+    _captureLoaded = true;
+    setByteDuration(SettingsDialog::byteDurationNs(header.baudRate, header.dataBits, header.parity, header.stopBits));
+
+    CaptureFile::Record record;
+    quint64 offset = reader.seek(reader.firstTimestamp() + startOffsetNs);
+    while (_rxStore.size() < CAPTURE_LOAD_LIMIT && reader.next(offset, record))
+    {
+        if (record.direction != CaptureFile::Rx)
+            continue;
+
+        _rxStore.append(record.data, record.length, record.timestamp);
+    }
+    presentIncoming();
+
+    showStatusMessage(tr("Запись %1: %2, %3 бод").arg(QFileInfo(fileName).fileName()).arg(header.portName).arg(header.baudRate));
+}
+
+void MainWindow::on_actionByteTime_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    setByteDuration(_byteDurationNs);
+}
 
-    DF_Player dfPlayer(_serialport);
-    dfPlayer.exec();
+void MainWindow::setByteDuration(qint64 nanoseconds)
+{
+    _byteDurationNs = nanoseconds;
 
-    connect(&_serialport, &QSerialPort::readyRead, this, &MainWindow::readData);
+    // Оценка времени каждой строки по скорости порта включается отдельно
+    const qint64 duration = ui->actionByteTime->isChecked() ? _byteDurationNs : 0;
+    ui->inData->setByteDuration(duration);
+    ui->inDataRaw->setByteDuration(duration);
 }
 
 void MainWindow::on_action_ASCII_triggered()
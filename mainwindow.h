@@ -1,6 +1,7 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QDockWidget>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QLabel>
@@ -8,13 +9,23 @@
 #include <QTime>
 #include <df_player.h>
 
+#include <memory>
+
+#include "bytesearch.h"
+#include "bytestore.h"
+#include "capturefile.h"
+#include "dfplayerfleetpanel.h"
+#include "framesplitter.h"
+#include "protocoldecoder.h"
+#include "portdispatcher.h"
+#include "presentationscheduler.h"
 #include "settingsdialog.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, public PortSubscriber
 {
     Q_OBJECT
 
@@ -22,6 +33,19 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Управление без участия пользователя (используется в benchmark)
+    bool openPort(const SettingsDialog::Settings &settings, bool threaded, QString &error);
+    void closePort();
+    void send(const QByteArray &data);
+
+    quint64 receivedBytes() const;
+    // Байты, потерянные читателем в потоковом режиме
+    quint64 droppedBytes() const;
+
+signals:
+    // Новые данные переданы панелям приёма для отрисовки
+    void incomingPresented(quint64 receivedBytes);
+
 private slots:
     void on_actionAboutQt_triggered();
     void on_actionQuit_triggered();
@@ -35,8 +59,7 @@ private slots:
     void on_endString_currentIndexChanged(int index);
 
     void write();
-    void readData();
-    void handleError(QSerialPort::SerialPortError error);
+    void handleError(QSerialPort::SerialPortError error, const QString &errorString);
 
     void on_clear_clicked();
 
@@ -46,29 +69,89 @@ private slots:
 
     void on_actionDF_Player_triggered();
 
+    void on_actionDF_Player_Fleet_triggered();
+
     void on_action_ASCII_triggered();
 
     void on_action_HEX_triggered();
 
     void on_actionASCII_HEX_triggered();
 
+    void presentIncoming();
+
+    void on_actionCapture_toggled(bool checked);
+
+    void on_actionOpenCapture_triggered();
+
+    void on_actionByteTime_toggled(bool checked);
+
+    void on_actionFrameTx_toggled(bool checked);
+
+    void searchChanged();
+    void on_searchNext_clicked();
+    void on_searchPrev_clicked();
+
 private:
     Ui::MainWindow *ui;
 
     SettingsDialog _settingDialog;
-    QSerialPort _serialport;
+    // Порт и раздача его данных: окну терминала, записи сеанса, панели DFPlayer
+    PortDispatcher _dispatcher;
     QLabel _statusLabel;
+    QLabel _frameStatusLabel;
+
+    // Принятые данные, общие для панелей ASCII и HEX
+    ByteStore _rxStore;
+    // В окне приёма открытая запись: её отметки переводятся в системное время по её заголовку
+    bool _captureLoaded = false;
+    PresentationScheduler _presentation;
+
+    // Разбиение приёма на кадры, те же правила кодируют отправку
+    FrameSplitter _framer;
+
+    // Декодер протокола для пояснений в окне приёма, nullptr - не выбран
+    std::unique_ptr<ProtocolDecoder> _decoder;
+
+    ByteSearch _search;
+    // Текущее совпадение, -1 - ещё не выбрано
+    qint64 _searchHit = -1;
+
+    // Запись сеанса, время записей отсчитывается по монотонным часам
+    CaptureWriter _capture;
+
+    // Состояние DFPlayer переживает панель DF_Player: при открытии оно показывается сразу
+    DFPlayerState _dfPlayerState;
+    DFPlayerCatalog _dfPlayerCatalog;
+    ProtocolLog _protocolLog;
+    // Панель создаётся при первом открытии и работает рядом с терминалом
+    QDockWidget *_dfPlayerDock = nullptr;
+    // Парк модулей на своих портах, независимо от порта терминала
+    QDockWidget *_dfPlayerFleetDock = nullptr;
+
+    // Длительность передачи байта при текущих параметрах порта
+    qint64 _byteDurationNs = 0;
 
     void showStatusMessage(const QString &message);
 
-    QString byteToHexString(uint8_t ch) const;
-    QString textToHexText(const QString &str, QString delim = "") const;
-    QString hexTextToText(const QString &str) const;
+    void setByteDuration(qint64 nanoseconds);
+
+    void setFraming(FrameSplitter::Mode mode);
+    void setDecoder(const QString &name);
+    void updateFrameStatus();
+
+    void showSearchHit(qint64 hit);
+    void updateSearchStatus();
+
+    QByteArray textToBytes(const QString &str) const;
 
     void disableAction(bool state);
 
     // QObject interface
 public:
     virtual bool eventFilter(QObject *watched, QEvent *event) override;
+
+    // PortSubscriber interface
+public:
+    virtual void portReceived(const QByteArray &data, qint64 timestamp) override;
 };
 #endif // MAINWINDOW_H
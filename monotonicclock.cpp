@@ -0,0 +1,54 @@
+#include "monotonicclock.h"
+
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
+namespace
+{
+struct Anchor
+{
+    qint64 monotonicNs;
+    qint64 wallClockMs;
+
+    Anchor()
+        : monotonicNs(MonotonicClock::nowNs()),
+          wallClockMs(QDateTime::currentMSecsSinceEpoch())
+    {
+    }
+};
+
+const Anchor &anchor()
+{
+    static const Anchor value;
+    return value;
+}
+}
+
+namespace MonotonicClock
+{
+qint64 nowNs()
+{
+#ifdef Q_OS_UNIX
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+qint64 anchorNs()
+{
+    return anchor().monotonicNs;
+}
+
+qint64 anchorWallClockMs()
+{
+    return anchor().wallClockMs;
+}
+}
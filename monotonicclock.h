@@ -0,0 +1,19 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+
+// Монотонные часы с наносекундным разрешением (CLOCK_MONOTONIC на unix).
+// Отметки хранятся целыми числами и переводятся в текст только при отображении.
+namespace MonotonicClock
+{
+const qint64 NS_PER_MS = 1000000;
+
+qint64 nowNs();
+
+// Соответствие монотонных часов и системного времени, зафиксированное при первом обращении
+qint64 anchorNs();
+qint64 anchorWallClockMs();
+}
+
+#endif // MONOTONICCLOCK_H
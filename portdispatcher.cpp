@@ -0,0 +1,232 @@
+#include "portdispatcher.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+
+// Ёмкость кольцевого буфера приёма для режима чтения в отдельном потоке
+static const size_t RX_RING_SIZE = 16 * 1024 * 1024;
+// Отметок времени на порцию - одна, порций меньше, чем байт
+static const size_t RX_CHUNK_RING_SIZE = 256 * 1024;
+
+PortDispatcher::PortDispatcher(QObject *parent)
+    : QObject(parent)
+{
+    connect(&_serialport, &QSerialPort::errorOccurred, this, &PortDispatcher::handlePortError);
+    connect(&_serialport, &QSerialPort::readyRead, this, &PortDispatcher::readPort);
+    connect(&_serialport, &QSerialPort::bytesWritten, this, &PortDispatcher::bytesWritten);
+
+    _readerThread.setObjectName(QStringLiteral("SerialReader"));
+}
+
+PortDispatcher::~PortDispatcher()
+{
+    closeThreadedReader();
+}
+
+void PortDispatcher::setReaderThread(QThread *thread)
+{
+    _sharedThread = thread;
+}
+
+bool PortDispatcher::open(const SettingsDialog::Settings &settings, bool threaded, QString &error)
+{
+    bool ok;
+    if (threaded)
+        ok = openThreadedReader(settings, error);
+    else
+    {
+        _serialport.setPortName(settings.name);
+        _serialport.setBaudRate(settings.baudRate);
+        _serialport.setDataBits(settings.dataBits);
+        _serialport.setParity(settings.parity);
+        _serialport.setStopBits(settings.stopBits);
+        _serialport.setFlowControl(settings.flowControl);
+
+        ok = _serialport.open(QIODevice::ReadWrite);
+        if (!ok)
+            error = _serialport.errorString();
+    }
+
+    if (ok)
+    {
+        _settings = settings;
+        emit opened();
+    }
+    return ok;
+}
+
+void PortDispatcher::close()
+{
+    const bool wasOpen = isOpen();
+
+    closeThreadedReader();
+    if (_serialport.isOpen())
+        _serialport.close();
+
+    if (wasOpen)
+        emit closed();
+}
+
+bool PortDispatcher::isOpen() const
+{
+    return _reader || _serialport.isOpen();
+}
+
+bool PortDispatcher::isThreaded() const
+{
+    return _reader != nullptr;
+}
+
+const SettingsDialog::Settings &PortDispatcher::settings() const
+{
+    return _settings;
+}
+
+void PortDispatcher::write(const QByteArray &data)
+{
+    if (_reader)
+    {
+        SerialReader *reader = _reader;
+        QMetaObject::invokeMethod(reader, [this, reader, data]() {
+            reader->write(data);
+            const qint64 written = MonotonicClock::nowNs();
+            QMetaObject::invokeMethod(this, [this, written]() { emit dataWritten(written); });
+        });
+    }
+    else if (_serialport.isOpen())
+        _serialport.write(data);
+    else
+        return;
+
+    const qint64 timestamp = MonotonicClock::nowNs();
+    const std::vector<PortSubscriber *> subscribers = _subscribers;
+    for (PortSubscriber *subscriber : subscribers)
+    {
+        if (isSubscribed(subscriber))
+            subscriber->portSent(data, timestamp);
+    }
+    if (!_reader)
+        emit dataWritten(timestamp);
+}
+
+qint64 PortDispatcher::bytesToWrite() const
+{
+    return _reader ? 0 : _serialport.bytesToWrite();
+}
+
+quint64 PortDispatcher::droppedBytes() const
+{
+    return _reader ? _reader->droppedBytes() : 0;
+}
+
+void PortDispatcher::subscribe(PortSubscriber *subscriber)
+{
+    if (!isSubscribed(subscriber))
+        _subscribers.push_back(subscriber);
+}
+
+void PortDispatcher::unsubscribe(PortSubscriber *subscriber)
+{
+    _subscribers.erase(std::remove(_subscribers.begin(), _subscribers.end(), subscriber), _subscribers.end());
+}
+
+bool PortDispatcher::openThreadedReader(const SettingsDialog::Settings &settings, QString &error)
+{
+    _rxRing.reset(new SpscRingBuffer<char>(RX_RING_SIZE));
+    _rxChunks.reset(new SpscRingBuffer<SerialReader::Chunk>(RX_CHUNK_RING_SIZE));
+
+    _reader = new SerialReader(*_rxRing, *_rxChunks);
+    connect(_reader, &SerialReader::dataAvailable, this, &PortDispatcher::readRing);
+    connect(_reader, &SerialReader::errorOccurred, this, &PortDispatcher::errorOccurred);
+    if (_sharedThread)
+        _reader->moveToThread(_sharedThread);
+    else
+    {
+        _reader->moveToThread(&_readerThread);
+        connect(&_readerThread, &QThread::finished, _reader, &QObject::deleteLater);
+        _readerThread.start(QThread::TimeCriticalPriority);
+    }
+
+    SerialReader *reader = _reader;
+    bool opened = false;
+    QMetaObject::invokeMethod(reader, [reader, &settings, &opened, &error]() {
+        opened = reader->open(settings);
+        if (!opened)
+            error = reader->errorString();
+    }, Qt::BlockingQueuedConnection);
+
+    if (!opened)
+        closeThreadedReader();
+
+    return opened;
+}
+
+void PortDispatcher::closeThreadedReader()
+{
+    if (!_reader)
+        return;
+
+    SerialReader *reader = _reader;
+    QMetaObject::invokeMethod(reader, [reader]() { reader->close(); }, Qt::BlockingQueuedConnection);
+    _reader = nullptr;
+
+    // Общий поток продолжает обслуживать другие порты - читатель удаляется в нём же
+    if (reader->thread() != &_readerThread)
+    {
+        reader->disconnect(this);
+        reader->deleteLater();
+        return;
+    }
+
+    // Объект читателя удаляется в своём потоке по сигналу finished
+    _readerThread.quit();
+    _readerThread.wait();
+}
+
+void PortDispatcher::readPort()
+{
+    const qint64 timestamp = MonotonicClock::nowNs();
+    dispatch(_serialport.readAll(), timestamp);
+}
+
+void PortDispatcher::readRing()
+{
+    if (!_reader)
+        return;
+
+    // Сначала сбрасываем флаг, чтобы не потерять уведомление о данных, пришедших во время чтения
+    _reader->acknowledge();
+
+    // Каждая порция забирается со своей отметкой времени, снятой потоком читателя
+    SerialReader::Chunk chunk;
+    while (_rxChunks->read(&chunk, 1) == 1)
+    {
+        QByteArray data(static_cast<int>(chunk.length), Qt::Uninitialized);
+        data.resize(static_cast<int>(_rxRing->read(data.data(), chunk.length)));
+        if (!data.isEmpty())
+            dispatch(data, chunk.timestamp);
+    }
+}
+
+void PortDispatcher::handlePortError(QSerialPort::SerialPortError error)
+{
+    if (error != QSerialPort::NoError)
+        emit errorOccurred(error, _serialport.errorString());
+}
+
+void PortDispatcher::dispatch(const QByteArray &data, qint64 timestamp)
+{
+    // Подписчик может отписаться (или подписать другого) прямо из обработчика:
+    // обход по копии списка, отписавшиеся по ходу пропускаются
+    const std::vector<PortSubscriber *> subscribers = _subscribers;
+    for (PortSubscriber *subscriber : subscribers)
+    {
+        if (isSubscribed(subscriber))
+            subscriber->portReceived(data, timestamp);
+    }
+}
+
+bool PortDispatcher::isSubscribed(PortSubscriber *subscriber) const
+{
+    return std::find(_subscribers.begin(), _subscribers.end(), subscriber) != _subscribers.end();
+}
@@ -0,0 +1,93 @@
+#ifndef PORTDISPATCHER_H
+#define PORTDISPATCHER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QSerialPort>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+#include "settingsdialog.h"
+#include "serialreader.h"
+#include "spscringbuffer.h"
+
+// Получатель данных порта. Порция передаётся по ссылке, один QByteArray на всех получателей;
+// кому данные нужны дольше вызова, копирует объект QByteArray (общий буфер, без копии байт).
+class PortSubscriber
+{
+public:
+    virtual ~PortSubscriber() = default;
+
+    virtual void portReceived(const QByteArray &data, qint64 timestamp) = 0;
+    virtual void portSent(const QByteArray &data, qint64 timestamp)
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(timestamp);
+    }
+};
+
+// Владелец порта: открывает его напрямую или через читателя в отдельном потоке и раздаёт
+// каждую принятую и отправленную порцию всем подписчикам (окно терминала, запись сеанса, DFPlayer).
+// Подписчики вызываются в потоке GUI в порядке подписки.
+// Читатель может работать в общем потоке пула ввода-вывода (парк модулей) вместо собственного.
+class PortDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortDispatcher(QObject *parent = nullptr);
+    ~PortDispatcher();
+
+    // Поток читателя для следующего открытия в потоковом режиме; nullptr - собственный поток
+    void setReaderThread(QThread *thread);
+
+    bool open(const SettingsDialog::Settings &settings, bool threaded, QString &error);
+    void close();
+
+    bool isOpen() const;
+    bool isThreaded() const;
+    const SettingsDialog::Settings &settings() const;
+
+    void write(const QByteArray &data);
+    // Байты, ещё не переданные драйверу; в потоковом режиме порт у читателя - всегда 0
+    qint64 bytesToWrite() const;
+    // Байты, потерянные читателем в потоковом режиме
+    quint64 droppedBytes() const;
+
+    void subscribe(PortSubscriber *subscriber);
+    void unsubscribe(PortSubscriber *subscriber);
+
+signals:
+    void opened();
+    void closed();
+    void bytesWritten(qint64 bytes);
+    // Порция из write() передана порту; в потоковом режиме время снимает поток читателя
+    void dataWritten(qint64 timestamp);
+    void errorOccurred(QSerialPort::SerialPortError error, const QString &errorString);
+
+private:
+    bool openThreadedReader(const SettingsDialog::Settings &settings, QString &error);
+    void closeThreadedReader();
+
+    void readPort();
+    void readRing();
+    void handlePortError(QSerialPort::SerialPortError error);
+    void dispatch(const QByteArray &data, qint64 timestamp);
+    bool isSubscribed(PortSubscriber *subscriber) const;
+
+    QSerialPort _serialport;
+    SettingsDialog::Settings _settings{};
+    std::vector<PortSubscriber *> _subscribers;
+
+    // Режим чтения в отдельном потоке
+    QThread _readerThread;
+    // Поток пула, в котором работает читатель; nullptr - _readerThread
+    QThread *_sharedThread = nullptr;
+    SerialReader *_reader = nullptr;
+    std::unique_ptr<SpscRingBuffer<char>> _rxRing;
+    std::unique_ptr<SpscRingBuffer<SerialReader::Chunk>> _rxChunks;
+};
+
+#endif // PORTDISPATCHER_H
@@ -0,0 +1,36 @@
+#include "presentationscheduler.h"
+
+PresentationScheduler::PresentationScheduler(QObject *parent)
+    : QObject(parent)
+{
+    _timer.setSingleShot(true);
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &PresentationScheduler::flush);
+}
+
+void PresentationScheduler::setFrameRate(int hz)
+{
+    _frameRate = qBound(1, hz, 240);
+}
+
+int PresentationScheduler::frameRate() const
+{
+    return _frameRate;
+}
+
+void PresentationScheduler::schedule()
+{
+    if (_timer.isActive())
+        return;
+
+    // После паузы первая порция показывается сразу, дальше - не чаще раза за кадр
+    const qint64 interval = 1000 / _frameRate;
+    const qint64 elapsed = _lastPresent.isValid() ? _lastPresent.elapsed() : interval;
+    _timer.start(static_cast<int>(qMax<qint64>(0, interval - elapsed)));
+}
+
+void PresentationScheduler::flush()
+{
+    _lastPresent.restart();
+    emit present();
+}
@@ -0,0 +1,34 @@
+#ifndef PRESENTATIONSCHEDULER_H
+#define PRESENTATIONSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+// Объединяет обновления интерфейса: сколько бы порций данных ни пришло,
+// сигнал present() выдаётся не чаще одного раза за кадр.
+class PresentationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PresentationScheduler(QObject *parent = nullptr);
+
+    void setFrameRate(int hz);
+    int frameRate() const;
+
+    // Появились новые данные для отображения
+    void schedule();
+
+signals:
+    void present();
+
+private:
+    void flush();
+
+    QTimer _timer;
+    QElapsedTimer _lastPresent;
+    int _frameRate = 60;
+};
+
+#endif // PRESENTATIONSCHEDULER_H
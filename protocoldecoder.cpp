@@ -0,0 +1,74 @@
+#include "protocoldecoder.h"
+#include "dfplayerdecoder.h"
+
+#include <algorithm>
+
+QStringList ProtocolDecoder::available()
+{
+    return {DFPlayerDecoder::NAME};
+}
+
+std::unique_ptr<ProtocolDecoder> ProtocolDecoder::create(const QString &name)
+{
+    if (name == DFPlayerDecoder::NAME)
+        return std::unique_ptr<ProtocolDecoder>(new DFPlayerDecoder);
+    return nullptr;
+}
+
+void ProtocolDecoder::setStore(const ByteStore *store)
+{
+    _store = store;
+    reset();
+}
+
+void ProtocolDecoder::update()
+{
+    if (!_store)
+        return;
+
+    // Запись может лежать в двух блоках хранилища - декодер получает её по частям
+    const std::vector<ByteStore::Record> &records = _store->records();
+    for (; _nextRecord < records.size(); ++_nextRecord)
+    {
+        const ByteStore::Record &record = records[_nextRecord];
+        quint64 offset = record.offset;
+        const quint64 end = record.offset + record.length;
+        while (offset < end)
+        {
+            size_t available;
+            const char *data = _store->span(offset, available);
+            const size_t size = static_cast<size_t>(qMin<quint64>(available, end - offset));
+            consume(data, size, offset, record.timestamp);
+            offset += size;
+        }
+    }
+}
+
+void ProtocolDecoder::reset()
+{
+    _packets.clear();
+    _packets.shrink_to_fit();
+    _nextRecord = 0;
+    clearState();
+}
+
+const std::vector<ProtocolDecoder::Packet> &ProtocolDecoder::packets() const
+{
+    return _packets;
+}
+
+std::pair<size_t, size_t> ProtocolDecoder::packetsEndingIn(quint64 offset, quint64 length) const
+{
+    // Пакеты не пересекаются, поэтому их концы тоже упорядочены
+    const auto endOf = [](const Packet &packet) { return packet.offset + packet.length; };
+    const auto first = std::upper_bound(_packets.begin(), _packets.end(), offset,
+                                        [&](quint64 value, const Packet &packet) { return value < endOf(packet); });
+    const auto last = std::upper_bound(first, _packets.end(), offset + length,
+                                       [&](quint64 value, const Packet &packet) { return value < endOf(packet); });
+    return {static_cast<size_t>(first - _packets.begin()), static_cast<size_t>(last - _packets.begin())};
+}
+
+void ProtocolDecoder::addPacket(const Packet &packet)
+{
+    _packets.push_back(packet);
+}
@@ -0,0 +1,71 @@
+#ifndef PROTOCOLDECODER_H
+#define PROTOCOLDECODER_H
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "bytestore.h"
+
+// Декодер протокола поверх ByteStore. Данные подаются участками по мере поступления (consume),
+// незавершённый пакет декодер держит в своём состоянии - поток целиком не перебуферизуется.
+// Пакеты хранят только положение в хранилище и разобранные поля, текст описания строится при отображении.
+class ProtocolDecoder
+{
+public:
+    enum Status
+    {
+        Valid,
+        ChecksumError,
+        FormatError
+    };
+
+    struct Packet
+    {
+        quint64 offset;
+        quint32 length;
+        qint64 timestamp;
+        quint16 type;       // код команды или сообщения
+        quint32 value;      // основной параметр
+        Status status;
+    };
+
+    virtual ~ProtocolDecoder() = default;
+
+    // Доступные декодеры и их создание по имени
+    static QStringList available();
+    static std::unique_ptr<ProtocolDecoder> create(const QString &name);
+
+    virtual QString name() const = 0;
+    // Описание пакета для показа рядом с данными
+    virtual QString describe(const Packet &packet) const = 0;
+
+    void setStore(const ByteStore *store);
+    // Разобрать записи, добавленные в хранилище с прошлого вызова
+    void update();
+    // Хранилище очищено
+    void reset();
+
+    const std::vector<Packet> &packets() const;
+    // Диапазон [first, second) пакетов, последний байт которых лежит в [offset, offset + length)
+    std::pair<size_t, size_t> packetsEndingIn(quint64 offset, quint64 length) const;
+
+protected:
+    // Очередной участок потока: offset - его положение в хранилище, timestamp - время приёма
+    virtual void consume(const char *data, size_t size, quint64 offset, qint64 timestamp) = 0;
+    // Сбросить незавершённый пакет
+    virtual void clearState() = 0;
+
+    void addPacket(const Packet &packet);
+
+private:
+    const ByteStore *_store = nullptr;
+    std::vector<Packet> _packets;
+    // Первая ещё не разобранная запись хранилища
+    size_t _nextRecord = 0;
+};
+
+#endif // PROTOCOLDECODER_H
@@ -0,0 +1,161 @@
+#include "protocollog.h"
+#include "dfplayercommands.h"
+#include "dfplayerdecoder.h"
+#include "monotonicclock.h"
+
+#include <QDateTime>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Пробуждение потока записи, если сигнал от писателя пропущен
+static const std::chrono::milliseconds WRITER_PERIOD(50);
+
+// Текст записи формируется только в потоке записи
+static QString format(const ProtocolLog::Record &record, const DFPlayerDecoder &decoder)
+{
+    const qint64 wallClockMs = MonotonicClock::anchorWallClockMs()
+            + (record.timestamp - MonotonicClock::anchorNs()) / MonotonicClock::NS_PER_MS;
+    const QString time = QDateTime::fromMSecsSinceEpoch(wallClockMs).toString(QStringLiteral("hh:mm:ss.zzz"));
+
+    if (record.kind == ProtocolLog::Rejected)
+    {
+        const QByteArray name(reinterpret_cast<const char *>(record.data), record.size);
+        return QStringLiteral("%1 rejected %2(%3, %4): parameter out of range")
+                .arg(time, QString::fromLatin1(name)).arg(record.value).arg(record.value2);
+    }
+
+    const QString bytes = QString::fromLatin1(QByteArray(reinterpret_cast<const char *>(record.data), record.size)
+                                              .toHex(':').toUpper());
+
+    // Текст пакета - тот же, что показывает декодер в окне приёма
+    ProtocolDecoder::Packet packet;
+    packet.offset = 0;
+    packet.length = record.size;
+    packet.timestamp = record.timestamp;
+    packet.type = record.size > CMD_VALUE ? record.data[CMD_VALUE] : 0;
+    packet.value = record.size > PARAM_LSB ? static_cast<quint32>((record.data[PARAM_MSB] << 8) | record.data[PARAM_LSB]) : 0;
+    packet.status = record.kind == ProtocolLog::ChecksumError ? ProtocolDecoder::ChecksumError
+                  : record.kind == ProtocolLog::FormatError ? ProtocolDecoder::FormatError : ProtocolDecoder::Valid;
+    const QString text = decoder.describe(packet);
+
+    switch (record.kind)
+    {
+    case ProtocolLog::Sent:
+        return QStringLiteral("%1 -> %2 %3").arg(time, bytes, text);
+    case ProtocolLog::Retransmitted:
+        return QStringLiteral("%1 -> %2 %3 (retransmit #%4)").arg(time, bytes, text).arg(record.value);
+    case ProtocolLog::Dropped:
+        return QStringLiteral("%1 -> %2 %3 (no acknowledgement, dropped)").arg(time, bytes, text);
+    default:
+        return QStringLiteral("%1 <- %2 %3").arg(time, bytes, text);
+    }
+}
+
+ProtocolLog::ProtocolLog(QObject *parent)
+    : QObject(parent),
+      _ring(RING_SIZE),
+      _level(Frames),
+      _console(true),
+      _lost(0),
+      _stop(false)
+{
+    // Привязка часов фиксируется в потоке GUI до запуска потока записи
+    MonotonicClock::anchorNs();
+    _writer = std::thread(&ProtocolLog::run, this);
+}
+
+ProtocolLog::~ProtocolLog()
+{
+    _stop.store(true, std::memory_order_release);
+    _wake.notify_one();
+    _writer.join();
+}
+
+void ProtocolLog::setLevel(Level level)
+{
+    _level.store(level, std::memory_order_relaxed);
+}
+
+ProtocolLog::Level ProtocolLog::level() const
+{
+    return static_cast<Level>(_level.load(std::memory_order_relaxed));
+}
+
+void ProtocolLog::setConsoleOutput(bool enabled)
+{
+    _console.store(enabled, std::memory_order_relaxed);
+}
+
+quint64 ProtocolLog::lost() const
+{
+    return _lost.load(std::memory_order_relaxed);
+}
+
+void ProtocolLog::push(Kind kind, const void *data, int size, quint16 value, quint16 value2)
+{
+    size_t length;
+    Record *record = _ring.writeSpan(length);
+    if (length == 0)
+    {
+        _lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    record->timestamp = MonotonicClock::nowNs();
+    record->kind = kind;
+    record->size = static_cast<quint8>(qBound(0, size, MAX_DATA));
+    record->value = value;
+    record->value2 = value2;
+    std::memcpy(record->data, data, record->size);
+    _ring.commitWrite(1);
+
+    _wake.notify_one();
+}
+
+void ProtocolLog::run()
+{
+    const DFPlayerDecoder decoder;
+    quint64 reportedLost = 0;
+    while (true)
+    {
+        QStringList lines;
+        size_t length;
+        const Record *records = _ring.readSpan(length);
+        while (length > 0)
+        {
+            for (size_t i = 0; i < length; ++i)
+                lines.append(format(records[i], decoder));
+            _ring.commitRead(length);
+            records = _ring.readSpan(length);
+        }
+
+        const quint64 lostNow = _lost.load(std::memory_order_relaxed);
+        if (lostNow != reportedLost)
+        {
+            lines.append(QStringLiteral("%1 log records lost").arg(lostNow - reportedLost));
+            reportedLost = lostNow;
+        }
+
+        if (!lines.isEmpty())
+        {
+            // Пачка строк - одна запись и один сброс буфера вместо printf+fflush на пакет
+            if (_console.load(std::memory_order_relaxed))
+            {
+                const QByteArray text = lines.join('\n').toLocal8Bit() + '\n';
+                std::fwrite(text.constData(), 1, static_cast<size_t>(text.size()), stdout);
+                std::fflush(stdout);
+            }
+            emit linesReady(lines);
+        }
+
+        if (_stop.load(std::memory_order_acquire) && _ring.readAvailable() == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(_wakeMutex);
+        _wake.wait_for(lock, WRITER_PERIOD, [this]() {
+            return _ring.readAvailable() > 0 || _stop.load(std::memory_order_acquire);
+        });
+    }
+}
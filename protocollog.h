@@ -0,0 +1,105 @@
+#ifndef PROTOCOLLOG_H
+#define PROTOCOLLOG_H
+
+#include <QObject>
+#include <QStringList>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "spscringbuffer.h"
+
+// Журнал обмена с DFPlayer. Поток GUI складывает двоичные записи (время, вид, сырой пакет)
+// в кольцевой буфер без блокировок, текст формирует отдельный поток записи: он выводит строки
+// в stdout пачками и передаёт их окну через сигнал linesReady.
+// Уровень подробности меняется на ходу; отключённый уровень стоит одной атомарной загрузки.
+class ProtocolLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Level
+    {
+        Off,
+        Errors,     // искажённые и потерянные пакеты, повторы, отклонённые команды
+        Frames      // и все отправленные и принятые пакеты
+    };
+
+    enum Kind : quint8
+    {
+        Sent,
+        Received,
+        ChecksumError,
+        FormatError,
+        Retransmitted,  // value - номер попытки
+        Dropped,        // не подтверждён после всех повторов
+        Rejected        // data - имя команды, value и value2 - параметры
+    };
+
+    static const int MAX_DATA = 24;
+
+    struct Record
+    {
+        qint64 timestamp;
+        Kind kind;
+        quint8 size;
+        quint16 value;
+        quint16 value2;
+        uchar data[MAX_DATA];
+    };
+
+    static const size_t RING_SIZE = 4096;
+
+    explicit ProtocolLog(QObject *parent = nullptr);
+    ~ProtocolLog();
+
+    void setLevel(Level level);
+    Level level() const;
+
+    static Level levelOf(Kind kind)
+    {
+        return kind == Sent || kind == Received ? Frames : Errors;
+    }
+
+    bool isEnabled(Kind kind) const
+    {
+        return levelOf(kind) <= _level.load(std::memory_order_relaxed);
+    }
+
+    // Вызывается только из одного потока (GUI); data усекается до MAX_DATA байт
+    void add(Kind kind, const void *data, int size, quint16 value = 0, quint16 value2 = 0)
+    {
+        if (isEnabled(kind))
+            push(kind, data, size, value, value2);
+    }
+
+    // Вывод в stdout (по умолчанию включён)
+    void setConsoleOutput(bool enabled);
+
+    // Записи, не поместившиеся в буфер
+    quint64 lost() const;
+
+signals:
+    // Отформатированные строки; испускается из потока записи
+    void linesReady(const QStringList &lines);
+
+private:
+    void push(Kind kind, const void *data, int size, quint16 value, quint16 value2);
+    void run();
+
+    SpscRingBuffer<Record> _ring;
+    std::atomic<int> _level;
+    std::atomic<bool> _console;
+    std::atomic<quint64> _lost;
+    std::atomic<bool> _stop;
+
+    // Пробуждение потока записи; писатель не ждёт мьютекс, пропущенное пробуждение
+    // ограничено периодом опроса
+    std::mutex _wakeMutex;
+    std::condition_variable _wake;
+    std::thread _writer;
+};
+
+#endif // PROTOCOLLOG_H
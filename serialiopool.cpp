@@ -0,0 +1,48 @@
+#include "serialiopool.h"
+
+#include <algorithm>
+
+SerialIoPool::SerialIoPool(int threads)
+{
+    _workers.resize(static_cast<size_t>(qMax(1, threads)));
+    for (size_t i = 0; i < _workers.size(); ++i)
+    {
+        _workers[i].thread.reset(new QThread);
+        _workers[i].thread->setObjectName(QStringLiteral("SerialIo%1").arg(i));
+        _workers[i].ports = 0;
+    }
+}
+
+SerialIoPool::~SerialIoPool()
+{
+    for (Worker &worker : _workers)
+    {
+        worker.thread->quit();
+        worker.thread->wait();
+    }
+}
+
+QThread *SerialIoPool::acquire()
+{
+    // Поток запускается, когда ему достаётся первый порт
+    Worker &worker = *std::min_element(_workers.begin(), _workers.end(),
+                                       [](const Worker &a, const Worker &b) { return a.ports < b.ports; });
+    if (!worker.thread->isRunning())
+        worker.thread->start(QThread::TimeCriticalPriority);
+    worker.ports++;
+    return worker.thread.get();
+}
+
+void SerialIoPool::release(QThread *thread)
+{
+    for (Worker &worker : _workers)
+    {
+        if (worker.thread.get() == thread && worker.ports > 0)
+            worker.ports--;
+    }
+}
+
+int SerialIoPool::threadCount() const
+{
+    return static_cast<int>(_workers.size());
+}
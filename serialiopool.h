@@ -0,0 +1,33 @@
+#ifndef SERIALIOPOOL_H
+#define SERIALIOPOOL_H
+
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+// Общие потоки ввода-вывода для многих портов. Читатель порта (SerialReader) получает поток,
+// обслуживающий меньше всего портов; порты одного потока работают в его цикле событий.
+// Потоков не больше числа ядер - десятки портов не превращаются в десятки потоков.
+class SerialIoPool
+{
+public:
+    explicit SerialIoPool(int threads = QThread::idealThreadCount());
+    ~SerialIoPool();
+
+    QThread *acquire();
+    void release(QThread *thread);
+
+    int threadCount() const;
+
+private:
+    struct Worker
+    {
+        std::unique_ptr<QThread> thread;
+        int ports;
+    };
+
+    std::vector<Worker> _workers;
+};
+
+#endif // SERIALIOPOOL_H
@@ -0,0 +1,100 @@
+#include "serialreader.h"
+#include "monotonicclock.h"
+
+SerialReader::SerialReader(SpscRingBuffer<char> &ring, SpscRingBuffer<Chunk> &chunks, QObject *parent)
+    : QObject(parent),
+      _serialport(this),
+      _ring(ring),
+      _chunks(chunks)
+{
+    connect(&_serialport, &QSerialPort::readyRead, this, &SerialReader::readPort);
+    connect(&_serialport, &QSerialPort::errorOccurred, this, &SerialReader::handleError);
+}
+
+bool SerialReader::open(const SettingsDialog::Settings &settings)
+{
+    _serialport.setPortName(settings.name);
+    _serialport.setBaudRate(settings.baudRate);
+    _serialport.setDataBits(settings.dataBits);
+    _serialport.setParity(settings.parity);
+    _serialport.setStopBits(settings.stopBits);
+    _serialport.setFlowControl(settings.flowControl);
+
+    _dropped = 0;
+    return _serialport.open(QIODevice::ReadWrite);
+}
+
+void SerialReader::close()
+{
+    if (_serialport.isOpen())
+        _serialport.close();
+}
+
+void SerialReader::write(const QByteArray &data)
+{
+    // Без ожидания следующего прохода цикла событий: пакеты разным портам пула уходят подряд
+    _serialport.write(data);
+    _serialport.flush();
+}
+
+QString SerialReader::errorString() const
+{
+    return _serialport.errorString();
+}
+
+void SerialReader::acknowledge()
+{
+    _notified.store(false, std::memory_order_release);
+}
+
+quint64 SerialReader::droppedBytes() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void SerialReader::readPort()
+{
+    // Отметка времени снимается сразу, до копирования данных
+    const qint64 timestamp = MonotonicClock::nowNs();
+    size_t received = 0;
+
+    // Читаем прямо в свободное место кольцевого буфера
+    while (_serialport.bytesAvailable() > 0)
+    {
+        size_t length;
+        char *span = _ring.writeSpan(length);
+        if (length == 0 || _chunks.writeAvailable() == 0)
+        {
+            // Буфер полон - порт всё равно опустошаем, чтобы не было переполнения в ядре
+            char scratch[4096];
+            const qint64 n = _serialport.read(scratch, sizeof(scratch));
+            if (n <= 0)
+                break;
+            _dropped.fetch_add(n, std::memory_order_relaxed);
+            continue;
+        }
+
+        const qint64 n = _serialport.read(span, static_cast<qint64>(length));
+        if (n <= 0)
+            break;
+        _ring.commitWrite(static_cast<size_t>(n));
+        received += static_cast<size_t>(n);
+    }
+
+    if (received == 0)
+        return;
+
+    // Отметка публикуется после данных: потребитель, увидев её, найдёт и все её байты
+    const Chunk chunk = {static_cast<quint32>(received), timestamp};
+    _chunks.write(&chunk, 1);
+
+    // Одно уведомление на всё, что накопилось, пока GUI не забрал данные
+    if (!_notified.exchange(true, std::memory_order_acq_rel))
+        emit dataAvailable();
+}
+
+void SerialReader::handleError(QSerialPort::SerialPortError error)
+{
+    if (error != QSerialPort::NoError)
+        emit errorOccurred(error, _serialport.errorString());
+}
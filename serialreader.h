@@ -0,0 +1,58 @@
+#ifndef SERIALREADER_H
+#define SERIALREADER_H
+
+#include <QObject>
+#include <QSerialPort>
+
+#include <atomic>
+
+#include "settingsdialog.h"
+#include "spscringbuffer.h"
+
+// Чтение порта в отдельном потоке. Порт принадлежит объекту, объект переносится в рабочий поток,
+// принятые байты складываются в кольцевой буфер, GUI только забирает их оттуда.
+// Время приёма снимается здесь же, при чтении, и передаётся вторым буфером - по отметке на порцию.
+class SerialReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Порция байт, прочитанная за один вызов readyRead
+    struct Chunk
+    {
+        quint32 length;
+        qint64 timestamp;
+    };
+
+    SerialReader(SpscRingBuffer<char> &ring, SpscRingBuffer<Chunk> &chunks, QObject *parent = nullptr);
+
+    // Вызываются в потоке читателя (через QMetaObject::invokeMethod)
+    bool open(const SettingsDialog::Settings &settings);
+    void close();
+    void write(const QByteArray &data);
+
+    QString errorString() const;
+
+    // Вызывается потребителем перед опустошением буфера, чтобы получить следующее уведомление
+    void acknowledge();
+
+    // Байты, не поместившиеся в буфер (GUI не успевает забирать)
+    quint64 droppedBytes() const;
+
+signals:
+    void dataAvailable();
+    void errorOccurred(QSerialPort::SerialPortError error, const QString &errorString);
+
+private:
+    void readPort();
+    void handleError(QSerialPort::SerialPortError error);
+
+    QSerialPort _serialport;
+    SpscRingBuffer<char> &_ring;
+    SpscRingBuffer<Chunk> &_chunks;
+
+    std::atomic<bool> _notified{false};
+    std::atomic<quint64> _dropped{0};
+};
+
+#endif // SERIALREADER_H
@@ -42,6 +42,22 @@ SettingsDialog::Settings SettingsDialog::settings() const
     return m_currentSettings;
 }
 
+// Старт-бит, данные, бит чётности и стоп-биты; полтора стоп-бита (OneAndHalfStop = 3) - в половинах бита
+qint64 SettingsDialog::byteDurationNs(qint32 baudRate, int dataBits, int parity, int stopBits)
+{
+    if (baudRate <= 0)
+        return 0;
+
+    const int halfBits = 2 * (1 + dataBits + (parity == QSerialPort::NoParity ? 0 : 1))
+            + (stopBits == QSerialPort::OneAndHalfStop ? 3 : 2 * stopBits);
+    return halfBits * 500000000LL / baudRate;
+}
+
+qint64 SettingsDialog::byteDurationNs(const Settings &settings)
+{
+    return byteDurationNs(settings.baudRate, settings.dataBits, settings.parity, settings.stopBits);
+}
+
 void SettingsDialog::showPortInfo(int idx)
 {
     if (idx == -1)
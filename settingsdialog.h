@@ -39,6 +39,10 @@ public:
 
     Settings settings() const;
 
+    // Время передачи одного символа, нс; 0 - скорость не задана
+    static qint64 byteDurationNs(qint32 baudRate, int dataBits, int parity, int stopBits);
+    static qint64 byteDurationNs(const Settings &settings);
+
 private slots:
     void showPortInfo(int idx);
     void apply();
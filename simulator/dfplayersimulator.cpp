@@ -0,0 +1,508 @@
+#include "dfplayersimulator.h"
+#include "monotonicclock.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <numeric>
+
+#include <unistd.h>
+
+// Коды ошибок 0x40 (те же, что показывает DFPlayerDecoder)
+static const quint8 ERROR_BUSY = 0x1;
+static const quint8 ERROR_SLEEPING = 0x2;
+static const quint8 ERROR_RECEIVING = 0x3;
+static const quint8 ERROR_CHECKSUM = 0x4;
+static const quint8 ERROR_OUT_OF_SCOPE = 0x5;
+static const quint8 ERROR_NOT_FOUND = 0x6;
+static const quint8 ERROR_INSERTION = 0x7;
+static const quint8 ERROR_READ_FAILED = 0x8;
+
+// Носители в сообщении 0x3F: 1 - USB, 2 - SD, 4 - оба
+static const quint16 ONLINE_USB = 1;
+static const quint16 ONLINE_SD = 2;
+static const quint16 ONLINE_BOTH = 4;
+
+DFPlayerSimulator::DFPlayerSimulator(int master, const Options &options, QObject *parent)
+    : QObject(parent),
+      _master(master),
+      _options(options),
+      _notifier(master, QSocketNotifier::Read),
+      _random(options.seed)
+{
+    connect(&_notifier, &QSocketNotifier::activated, this, &DFPlayerSimulator::readMaster);
+
+    _sendTimer.setSingleShot(true);
+    _sendTimer.setTimerType(Qt::PreciseTimer);
+    connect(&_sendTimer, &QTimer::timeout, this, &DFPlayerSimulator::sendDue);
+
+    _trackTimer.setSingleShot(true);
+    connect(&_trackTimer, &QTimer::timeout, this, &DFPlayerSimulator::trackFinished);
+    _advertTimer.setSingleShot(true);
+    connect(&_advertTimer, &QTimer::timeout, this, &DFPlayerSimulator::advertFinished);
+    _resetTimer.setSingleShot(true);
+    connect(&_resetTimer, &QTimer::timeout, this, &DFPlayerSimulator::initialized);
+
+    if (!isPresent(Sd) && isPresent(Usb))
+        _device = Usb;
+}
+
+const DFPlayerSimulator::Statistics &DFPlayerSimulator::statistics() const
+{
+    return _statistics;
+}
+
+void DFPlayerSimulator::readMaster()
+{
+    char buffer[4096];
+    const ssize_t n = ::read(_master, buffer, sizeof(buffer));
+    if (n <= 0)
+    {
+        // Подчинённую сторону закрыли: ждём следующего открытия, не крутясь в цикле
+        if (n < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            _notifier.setEnabled(false);
+            QTimer::singleShot(100, this, [this]() { _notifier.setEnabled(true); });
+        }
+        return;
+    }
+
+    _parser.feed(buffer, static_cast<size_t>(n), _offset,
+                 [this](const DFPlayerFrameParser::Frame &frame) { handleFrame(frame); });
+    _offset += static_cast<quint64>(n);
+}
+
+void DFPlayerSimulator::handleFrame(const DFPlayerFrameParser::Frame &frame)
+{
+    // Потерянный на линии пакет модуль просто не видит
+    if (chance(_options.dropRate))
+    {
+        ++_statistics.lostReceived;
+        return;
+    }
+
+    if (frame.status != DFPlayerFrameParser::Valid)
+    {
+        ++_statistics.corruptReceived;
+        error(frame.status == DFPlayerFrameParser::ChecksumError ? ERROR_CHECKSUM : ERROR_RECEIVING);
+        return;
+    }
+
+    ++_statistics.received;
+    execute(frame.command, frame.value, frame.feedback != NO_FEEDBACK);
+}
+
+void DFPlayerSimulator::execute(quint8 command, quint16 param, bool feedback)
+{
+    if (_busy)
+    {
+        error(ERROR_BUSY);
+        return;
+    }
+    // Из сна выводят только сброс и выбор носителя
+    if (_sleeping && command != CTRL_RESET && command != CTRL_PLAYBACK_SRC)
+    {
+        error(ERROR_SLEEPING);
+        return;
+    }
+
+    const quint8 msb = static_cast<quint8>(param >> 8);
+    const quint8 lsb = static_cast<quint8>(param);
+    const int files = fileCount(_device);
+    const int track = _track[_device];
+
+    quint8 code = 0;
+    // Ответ на запрос, 0 - команда без ответа
+    quint8 replyCommand = 0;
+    quint16 replyValue = 0;
+
+    switch (command)
+    {
+    case CTRL_NEXT:
+        code = play(files > 0 ? track % files + 1 : 1);
+        break;
+    case CTRL_PREV:
+        code = play(track > 1 ? track - 1 : files);
+        break;
+    case CTRL_SPEC_PLAY:
+    case CTRL_SPEC_PLAY_MP3:
+        code = play(param);
+        break;
+    case CTRL_INC_VOL:
+        _volume = qMin(_volume + 1, 30);
+        break;
+    case CTRL_DEC_VOL:
+        _volume = qMax(_volume - 1, 0);
+        break;
+    case CTRL_VOLUME:
+        _volume = qMin<int>(param, 30);
+        break;
+    case CTRL_EQ:
+        _equalizer = qMin<int>(param, EQ_BASE);
+        break;
+    case CTRL_PLAYBACK_MODE:
+        code = play(param);
+        if (code == 0)
+            _repeat = RepeatTrack;
+        break;
+    case CTRL_PLAYBACK_SRC:
+    {
+        const Device device = param == SRC_USB ? Usb : Sd;
+        if (!isPresent(device))
+        {
+            code = ERROR_INSERTION;
+            break;
+        }
+        stop();
+        _device = device;
+        _sleeping = false;
+        break;
+    }
+    case CTRL_SLEEP:
+        stop();
+        _sleeping = true;
+        break;
+    case CTRL_RESET:
+        // Модуль занят до окончания инициализации и сообщает о носителях сам
+        stop();
+        _repeat = NoRepeat;
+        _volume = DEFAULT_VOLUME;
+        _equalizer = EQ_NORMAL;
+        _sleeping = false;
+        _busy = true;
+        _resetTimer.start(_options.resetMs);
+        break;
+    case CTRL_PLAY:
+        if (_status == Paused)
+            resume();
+        else if (_status == Stopped)
+            code = play(qMax(track, 1));
+        break;
+    case CTRL_PAUSE:
+        if (_status == Playing)
+            pause();
+        break;
+    case CTRL_SPEC_FOLDER:
+        code = play(fileOf(_device, msb, lsb));
+        break;
+    case CTRL_SPEC_TRACK_3000:
+        code = play(fileOf(_device, param >> 12, param & 0x0FFF));
+        break;
+    case CTRL_AUDIO_AMPL:
+    case CTRL_SET_DAC:
+        break;
+    case CTRL_REPEAT_PLAY:
+        _repeat = param ? RepeatAll : NoRepeat;
+        if (param && _status == Stopped)
+            code = play(1);
+        break;
+    case CTRL_INSERT_ADVERT:
+        // Объявление прерывает только играющий трек
+        if (_status != Playing || _advertTimer.isActive())
+            code = ERROR_BUSY;
+        else if (param < 1 || param > _options.adverts)
+            code = ERROR_NOT_FOUND;
+        else
+        {
+            _remainingMs = qMax(0, _trackTimer.remainingTime());
+            _trackTimer.stop();
+            _advertTimer.start(_options.advertMs);
+        }
+        break;
+    case CTRL_STOP_ADVERT:
+        if (_advertTimer.isActive())
+        {
+            _advertTimer.stop();
+            advertFinished();
+        }
+        break;
+    case CTRL_STOP:
+        stop();
+        break;
+    case CTRL_REPEAT_FOLDER:
+    {
+        const int first = fileOf(_device, param, 1);
+        code = play(first);
+        if (code == 0)
+        {
+            _repeat = RepeatFolder;
+            _repeatFolder = param;
+        }
+        break;
+    }
+    case CTRL_RANDOM_ALL:
+        code = play(files > 0 ? static_cast<int>(_random() % static_cast<quint32>(files)) + 1 : 0);
+        if (code == 0)
+            _repeat = Random;
+        break;
+    case CTRL_REPEAT_CURRENT:
+        // 0 - включить, 1 - выключить; действует только при воспроизведении
+        if (_status == Playing)
+            _repeat = param == 0 ? RepeatTrack : NoRepeat;
+        break;
+
+    case CMD_CUR_DEV_ONLINE:
+        replyCommand = CMD_CUR_DEV_ONLINE;
+        replyValue = static_cast<quint16>(onlineDevices());
+        break;
+    case CMD_STATUS:
+        replyCommand = CMD_STATUS;
+        replyValue = static_cast<quint16>(((_device == Usb ? 1 : 2) << 8) | _status);
+        break;
+    case CMD_VOLUME:
+        replyCommand = CMD_VOLUME;
+        replyValue = static_cast<quint16>(_volume);
+        break;
+    case CMD_EQ:
+        replyCommand = CMD_EQ;
+        replyValue = static_cast<quint16>(_equalizer);
+        break;
+    case CMD_USB_FILES:
+    case CMD_SD_FILES:
+        replyCommand = command;
+        replyValue = static_cast<quint16>(fileCount(command == CMD_USB_FILES ? Usb : Sd));
+        break;
+    case CMD_USB_TRACK:
+    case CMD_SD_TRACK:
+        replyCommand = command;
+        replyValue = static_cast<quint16>(_track[command == CMD_USB_TRACK ? Usb : Sd]);
+        break;
+    case CMD_FOLDER_FILES:
+    {
+        const int tracks = folderTracks(_device, param);
+        if (tracks <= 0)
+            code = ERROR_NOT_FOUND;
+        replyCommand = CMD_FOLDER_FILES;
+        replyValue = static_cast<quint16>(tracks);
+        break;
+    }
+    case CMD_FOLDERS:
+        replyCommand = CMD_FOLDERS;
+        replyValue = static_cast<quint16>(_device == Usb ? _options.usbFolders.size() : _options.sdFolders.size());
+        break;
+
+    default:
+        // Неизвестные коды модуль молча пропускает
+        return;
+    }
+
+    if (code != 0)
+    {
+        error(code);
+        return;
+    }
+
+    // Подтверждение уходит раньше ответа на запрос
+    if (feedback)
+    {
+        ++_statistics.acks;
+        reply(CMD_FEEDBACK, 0);
+    }
+    if (replyCommand != 0)
+        reply(replyCommand, replyValue);
+}
+
+void DFPlayerSimulator::reply(quint8 command, quint16 param, qint64 delayMs)
+{
+    if (delayMs < 0)
+    {
+        delayMs = _options.latencyMs;
+        if (_options.jitterMs > 0)
+            delayMs += static_cast<qint64>(_random() % static_cast<quint32>(_options.jitterMs + 1));
+    }
+
+    const qint64 due = qMax(MonotonicClock::nowNs() + delayMs * MonotonicClock::NS_PER_MS, _lastDue);
+    _lastDue = due;
+    _replies.push_back({due, DFPlayerCommands::buildFrame(command, param)});
+    scheduleSend();
+}
+
+void DFPlayerSimulator::error(quint8 code)
+{
+    ++_statistics.errors;
+    reply(CMD_ERROR, code);
+}
+
+void DFPlayerSimulator::sendDue()
+{
+    const qint64 now = MonotonicClock::nowNs();
+    while (!_replies.empty() && _replies.front().due <= now)
+    {
+        DFPlayerCommands::Frame frame = _replies.front().frame;
+        _replies.pop_front();
+
+        if (chance(_options.dropRate))
+        {
+            ++_statistics.lostSent;
+            continue;
+        }
+        // Искажается один байт после стартового: хост должен отбросить пакет и найти следующий
+        if (chance(_options.corruptRate))
+        {
+            frame[1 + _random() % (BUFFER_SIZE - 1)] ^= static_cast<uchar>(1 + _random() % 255);
+            ++_statistics.corrupted;
+        }
+
+        const uchar *data = frame.data();
+        size_t size = frame.size();
+        while (size > 0)
+        {
+            const ssize_t n = ::write(_master, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        ++_statistics.sent;
+    }
+    scheduleSend();
+}
+
+void DFPlayerSimulator::scheduleSend()
+{
+    if (_replies.empty() || _sendTimer.isActive())
+        return;
+
+    const qint64 wait = qMax<qint64>(0, _replies.front().due - MonotonicClock::nowNs());
+    _sendTimer.start(static_cast<int>((wait + MonotonicClock::NS_PER_MS - 1) / MonotonicClock::NS_PER_MS));
+}
+
+bool DFPlayerSimulator::isPresent(Device device) const
+{
+    return !(device == Usb ? _options.usbFolders : _options.sdFolders).empty();
+}
+
+int DFPlayerSimulator::fileCount(Device device) const
+{
+    const std::vector<int> &folders = device == Usb ? _options.usbFolders : _options.sdFolders;
+    return std::accumulate(folders.begin(), folders.end(), 0);
+}
+
+int DFPlayerSimulator::folderTracks(Device device, int folder) const
+{
+    const std::vector<int> &folders = device == Usb ? _options.usbFolders : _options.sdFolders;
+    return folder >= 1 && folder <= static_cast<int>(folders.size()) ? folders[static_cast<size_t>(folder - 1)] : 0;
+}
+
+int DFPlayerSimulator::fileOf(Device device, int folder, int track) const
+{
+    const int tracks = folderTracks(device, folder);
+    if (track < 1 || track > tracks)
+        return 0;
+
+    // Файлы нумеруются подряд по папкам, как в порядке записи на носитель
+    const std::vector<int> &folders = device == Usb ? _options.usbFolders : _options.sdFolders;
+    return std::accumulate(folders.begin(), folders.begin() + (folder - 1), 0) + track;
+}
+
+int DFPlayerSimulator::onlineDevices() const
+{
+    if (isPresent(Usb) && isPresent(Sd))
+        return ONLINE_BOTH;
+    return isPresent(Usb) ? ONLINE_USB : isPresent(Sd) ? ONLINE_SD : 0;
+}
+
+int DFPlayerSimulator::trackDuration(int file) const
+{
+    // Длительность постоянна для файла (0.5..1.5 средней): каталог хоста может её запомнить
+    const quint32 spread = static_cast<quint32>(qMax(1, _options.trackMs));
+    return _options.trackMs / 2 + static_cast<int>(static_cast<quint32>(file) * 2654435761u % spread);
+}
+
+bool DFPlayerSimulator::chance(double rate)
+{
+    return rate > 0 && std::uniform_real_distribution<double>(0, 1)(_random) < rate;
+}
+
+quint8 DFPlayerSimulator::play(int file)
+{
+    if (!isPresent(_device))
+        return ERROR_READ_FAILED;
+    if (file < 1 || file > fileCount(_device))
+        return file == 0 ? ERROR_NOT_FOUND : ERROR_OUT_OF_SCOPE;
+
+    startTrack(file);
+    return 0;
+}
+
+void DFPlayerSimulator::startTrack(int file)
+{
+    _track[_device] = file;
+    _status = Playing;
+    _advertTimer.stop();
+    _trackTimer.start(trackDuration(file));
+}
+
+void DFPlayerSimulator::pause()
+{
+    if (_trackTimer.isActive())
+        _remainingMs = qMax(0, _trackTimer.remainingTime());
+    // Объявление на паузе не продолжается - после неё дослушивается трек
+    _trackTimer.stop();
+    _advertTimer.stop();
+    _status = Paused;
+}
+
+void DFPlayerSimulator::resume()
+{
+    _status = Playing;
+    _trackTimer.start(_remainingMs);
+}
+
+void DFPlayerSimulator::stop()
+{
+    _trackTimer.stop();
+    _advertTimer.stop();
+    _status = Stopped;
+}
+
+void DFPlayerSimulator::trackFinished()
+{
+    ++_statistics.tracksFinished;
+
+    // Сообщение об окончании не ждёт обработки команды - только очереди ответов.
+    // Модуль присылает его дважды, второе - вслед за первым
+    const int file = _track[_device];
+    const quint8 command = _device == Usb ? CMD_TRACK_FINSH_USB : CMD_TRACK_FINSH_SD;
+    reply(command, static_cast<quint16>(file), 0);
+    reply(command, static_cast<quint16>(file));
+
+    const int files = fileCount(_device);
+    switch (_repeat)
+    {
+    case RepeatTrack:
+        startTrack(file);
+        break;
+    case RepeatAll:
+        startTrack(file % files + 1);
+        break;
+    case RepeatFolder:
+    {
+        const int first = fileOf(_device, _repeatFolder, 1);
+        const int tracks = folderTracks(_device, _repeatFolder);
+        startTrack(first + (file - first + 1) % tracks);
+        break;
+    }
+    case Random:
+        startTrack(static_cast<int>(_random() % static_cast<quint32>(files)) + 1);
+        break;
+    default:
+        _status = Stopped;
+    }
+}
+
+void DFPlayerSimulator::advertFinished()
+{
+    // После объявления трек продолжается с места прерывания
+    if (_status == Playing)
+        _trackTimer.start(_remainingMs);
+}
+
+void DFPlayerSimulator::initialized()
+{
+    _busy = false;
+    reply(CMD_CUR_DEV_ONLINE, static_cast<quint16>(onlineDevices()), 0);
+}
@@ -0,0 +1,151 @@
+#ifndef DFPLAYERSIMULATOR_H
+#define DFPLAYERSIMULATOR_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "dfplayercommands.h"
+#include "dfplayerframeparser.h"
+
+// Имитатор модуля DFPlayer Mini (YX5200) на ведущей стороне псевдотерминала.
+// Разбирает пакеты команд из dfplayercommands.h, отвечает на запросы по виртуальному дереву файлов
+// SD и USB, ведёт таймер трека и сообщает о его окончании (0x3C/0x3D, дважды подряд), подтверждает
+// команды с битом FEEDBACK (0x41) и отвечает кодами ошибок 0x40, как модуль.
+// Ответы уходят с задержкой и разбросом; пакеты в обе стороны могут теряться, ответы - искажаться.
+// Случайные величины - от заданного зерна, прогон повторяется при тех же параметрах.
+class DFPlayerSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        int latencyMs = 10;         // от приёма команды до ответа
+        int jitterMs = 0;           // к задержке добавляется равномерно 0..jitterMs
+        double corruptRate = 0;     // доля отправленных пакетов с искажённым байтом
+        double dropRate = 0;        // доля потерянных пакетов (и принятых, и отправленных)
+        // Треков в папках 01, 02... носителя; пусто - носитель не вставлен
+        std::vector<int> sdFolders = {10, 10, 10};
+        std::vector<int> usbFolders;
+        int adverts = 5;            // файлов в папке ADVERT
+        int trackMs = 5000;         // средняя длительность трека
+        int advertMs = 2000;
+        int resetMs = 1500;         // инициализация после сброса: модуль занят
+        quint32 seed = 1;
+    };
+
+    struct Statistics
+    {
+        quint64 received = 0;       // принято верных пакетов
+        quint64 corruptReceived = 0;
+        quint64 lostReceived = 0;   // потеряны по dropRate
+        quint64 sent = 0;
+        quint64 acks = 0;
+        quint64 errors = 0;
+        quint64 tracksFinished = 0;
+        quint64 corrupted = 0;
+        quint64 lostSent = 0;
+    };
+
+    // master - ведущая сторона pty, имитатор её не закрывает
+    DFPlayerSimulator(int master, const Options &options, QObject *parent = nullptr);
+
+    const Statistics &statistics() const;
+
+private:
+    static const int DEFAULT_VOLUME = 20;
+
+    enum Device
+    {
+        Usb,
+        Sd,
+        DEVICE_COUNT
+    };
+
+    enum Status
+    {
+        Stopped,
+        Playing,
+        Paused
+    };
+
+    enum Repeat
+    {
+        NoRepeat,
+        RepeatTrack,
+        RepeatAll,
+        RepeatFolder,
+        Random
+    };
+
+    struct Reply
+    {
+        qint64 due;
+        DFPlayerCommands::Frame frame;
+    };
+
+    void readMaster();
+    void handleFrame(const DFPlayerFrameParser::Frame &frame);
+    void execute(quint8 command, quint16 param, bool feedback);
+
+    // Ответ уходит не раньше предыдущего: порядок сохраняется при любом разбросе задержки
+    void reply(quint8 command, quint16 param, qint64 delayMs = -1);
+    void error(quint8 code);
+    void sendDue();
+    void scheduleSend();
+
+    bool isPresent(Device device) const;
+    int fileCount(Device device) const;
+    int folderTracks(Device device, int folder) const;
+    // Номер файла носителя по папке и треку, 0 - такого нет
+    int fileOf(Device device, int folder, int track) const;
+    int onlineDevices() const;
+    int trackDuration(int file) const;
+    bool chance(double rate);
+
+    quint8 play(int file);
+    void startTrack(int file);
+    void pause();
+    void resume();
+    void stop();
+    void trackFinished();
+    void advertFinished();
+    void initialized();
+
+    const int _master;
+    const Options _options;
+    QSocketNotifier _notifier;
+    DFPlayerFrameParser _parser;
+    quint64 _offset = 0;
+    std::mt19937 _random;
+
+    std::deque<Reply> _replies;
+    qint64 _lastDue = 0;
+    QTimer _sendTimer;
+
+    // Состояние модуля
+    Device _device = Sd;
+    Status _status = Stopped;
+    Repeat _repeat = NoRepeat;
+    int _repeatFolder = 0;
+    int _track[DEVICE_COUNT] = {0, 0};
+    int _volume = DEFAULT_VOLUME;
+    int _equalizer = EQ_NORMAL;
+    bool _sleeping = false;
+    bool _busy = false;
+
+    QTimer _trackTimer;
+    QTimer _advertTimer;
+    QTimer _resetTimer;
+    // Остаток трека на паузе или во время объявления, мс
+    int _remainingMs = 0;
+
+    Statistics _statistics;
+};
+
+#endif // DFPLAYERSIMULATOR_H
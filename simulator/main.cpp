@@ -0,0 +1,147 @@
+// Имитатор DFPlayer Mini на псевдотерминале: проверка DF_Player и замеры без модуля на столе.
+//
+// Создаётся пара pty (openpty); имя подчинённой стороны печатается при запуске, терминал открывает её
+// как обычный последовательный порт. Имитатор работает до Ctrl+C (или --duration) и печатает счётчики.
+//
+//   dfplayer_simulator --sd 10,20,5 --usb 12 --latency 20 --jitter 10 --corrupt 0.01 --drop 0.01
+//                      [--track-ms 5000] [--link /tmp/dfplayer] [--seed 1]
+
+#include "dfplayersimulator.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTimer>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+std::atomic<bool> interrupted{false};
+
+void handleSignal(int)
+{
+    interrupted = true;
+}
+
+// "10,20,5" - треков в папках 01, 02, 03; пустая строка - носитель не вставлен
+std::vector<int> parseFolders(const QString &text)
+{
+    std::vector<int> folders;
+    for (const QString &part : text.split(','))
+    {
+        if (!part.trimmed().isEmpty())
+            folders.push_back(qBound(0, part.trimmed().toInt(), 3000));
+    }
+    return folders;
+}
+
+void printReport(const DFPlayerSimulator::Statistics &statistics)
+{
+    std::printf("received:       %llu frames (corrupt %llu, lost %llu)\n",
+                static_cast<unsigned long long>(statistics.received),
+                static_cast<unsigned long long>(statistics.corruptReceived),
+                static_cast<unsigned long long>(statistics.lostReceived));
+    std::printf("sent:           %llu frames (acks %llu, errors %llu, tracks finished %llu)\n",
+                static_cast<unsigned long long>(statistics.sent),
+                static_cast<unsigned long long>(statistics.acks),
+                static_cast<unsigned long long>(statistics.errors),
+                static_cast<unsigned long long>(statistics.tracksFinished));
+    std::printf("injected:       %llu corrupted, %llu lost\n",
+                static_cast<unsigned long long>(statistics.corrupted),
+                static_cast<unsigned long long>(statistics.lostSent));
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("DFPlayer Mini simulator on a pseudo-terminal"));
+    parser.addHelpOption();
+    parser.addOptions({
+        {QStringLiteral("sd"), QStringLiteral("Tracks per SD folder, comma separated (empty = no card)."), QStringLiteral("list"), QStringLiteral("10,10,10")},
+        {QStringLiteral("usb"), QStringLiteral("Tracks per USB folder, comma separated (empty = no drive)."), QStringLiteral("list"), QString()},
+        {QStringLiteral("adverts"), QStringLiteral("Files in the ADVERT folder."), QStringLiteral("count"), QStringLiteral("5")},
+        {QStringLiteral("track-ms"), QStringLiteral("Mean track duration, ms."), QStringLiteral("ms"), QStringLiteral("5000")},
+        {QStringLiteral("advert-ms"), QStringLiteral("Advertisement duration, ms."), QStringLiteral("ms"), QStringLiteral("2000")},
+        {QStringLiteral("reset-ms"), QStringLiteral("Busy time after reset, ms."), QStringLiteral("ms"), QStringLiteral("1500")},
+        {QStringLiteral("latency"), QStringLiteral("Reply latency, ms."), QStringLiteral("ms"), QStringLiteral("10")},
+        {QStringLiteral("jitter"), QStringLiteral("Extra random latency 0..jitter, ms."), QStringLiteral("ms"), QStringLiteral("0")},
+        {QStringLiteral("corrupt"), QStringLiteral("Fraction of sent frames with a corrupted byte."), QStringLiteral("rate"), QStringLiteral("0")},
+        {QStringLiteral("drop"), QStringLiteral("Fraction of frames lost in each direction."), QStringLiteral("rate"), QStringLiteral("0")},
+        {QStringLiteral("seed"), QStringLiteral("Random seed."), QStringLiteral("seed"), QStringLiteral("1")},
+        {QStringLiteral("duration"), QStringLiteral("Run time, seconds (0 = until interrupted)."), QStringLiteral("seconds"), QStringLiteral("0")},
+        {QStringLiteral("link"), QStringLiteral("Symlink to the port device, for a stable port name."), QStringLiteral("path")}
+    });
+    parser.process(app);
+
+    DFPlayerSimulator::Options options;
+    options.sdFolders = parseFolders(parser.value(QStringLiteral("sd")));
+    options.usbFolders = parseFolders(parser.value(QStringLiteral("usb")));
+    options.adverts = parser.value(QStringLiteral("adverts")).toInt();
+    options.trackMs = qMax(1, parser.value(QStringLiteral("track-ms")).toInt());
+    options.advertMs = qMax(1, parser.value(QStringLiteral("advert-ms")).toInt());
+    options.resetMs = qMax(0, parser.value(QStringLiteral("reset-ms")).toInt());
+    options.latencyMs = qMax(0, parser.value(QStringLiteral("latency")).toInt());
+    options.jitterMs = qMax(0, parser.value(QStringLiteral("jitter")).toInt());
+    options.corruptRate = qBound(0.0, parser.value(QStringLiteral("corrupt")).toDouble(), 1.0);
+    options.dropRate = qBound(0.0, parser.value(QStringLiteral("drop")).toDouble(), 1.0);
+    options.seed = parser.value(QStringLiteral("seed")).toUInt();
+    const int duration = parser.value(QStringLiteral("duration")).toInt();
+
+    int master, slave;
+    char slaveName[256];
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) != 0)
+    {
+        std::perror("openpty");
+        return 1;
+    }
+
+    // Подчинённая сторона остаётся открытой: закрытие порта терминалом не обрывает pty,
+    // и пакеты не искажаются обработкой строк до того, как порт его настроит
+    termios tty;
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    const QString link = parser.value(QStringLiteral("link"));
+    if (!link.isEmpty())
+    {
+        QFile::remove(link);
+        if (!QFile::link(QString::fromLocal8Bit(slaveName), link))
+            std::fprintf(stderr, "cannot create link %s\n", qPrintable(link));
+    }
+
+    std::printf("port:           %s\n", slaveName);
+    std::fflush(stdout);
+
+    DFPlayerSimulator simulator(master, options);
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    QTimer monitor;
+    QObject::connect(&monitor, &QTimer::timeout, &app, [&]() {
+        if (interrupted)
+            app.quit();
+    });
+    monitor.start(100);
+    if (duration > 0)
+        QTimer::singleShot(duration * 1000, &app, &QCoreApplication::quit);
+
+    app.exec();
+
+    printReport(simulator.statistics());
+    if (!link.isEmpty())
+        QFile::remove(link);
+    ::close(slave);
+    ::close(master);
+    return 0;
+}
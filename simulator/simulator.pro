@@ -0,0 +1,27 @@
+# Имитатор модуля DFPlayer Mini на псевдотерминале (только Linux/unix).
+# Сборка отдельно от приложения: qmake simulator/simulator.pro && make
+
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = dfplayer_simulator
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    dfplayersimulator.cpp \
+    main.cpp \
+    ../dfplayercommands.cpp \
+    ../dfplayerframeparser.cpp \
+    ../monotonicclock.cpp
+
+HEADERS += \
+    dfplayersimulator.h \
+    ../dfplayercommands.h \
+    ../dfplayerframeparser.h \
+    ../monotonicclock.h
+
+LIBS += -lutil
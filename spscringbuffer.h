@@ -0,0 +1,132 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Кольцевой буфер без блокировок для одного писателя и одного читателя.
+// Память выделяется один раз в конструкторе, ёмкость округляется до степени двойки.
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRingBuffer requires trivially copyable T");
+
+public:
+    explicit SpscRingBuffer(size_t capacity)
+        : _capacity(roundUpPow2(capacity)),
+          _mask(_capacity - 1),
+          _data(new T[_capacity])
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    // Вызывается только читателем
+    size_t readAvailable() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    // Вызывается только писателем
+    size_t writeAvailable() const
+    {
+        return _capacity - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    // Писатель: непрерывный свободный участок для записи "на месте" (без промежуточного буфера).
+    // После заполнения нужно вызвать commitWrite().
+    T *writeSpan(size_t &length)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t free = _capacity - (head - _tail.load(std::memory_order_acquire));
+        const size_t offset = head & _mask;
+        length = free < _capacity - offset ? free : _capacity - offset;
+        return _data.get() + offset;
+    }
+
+    void commitWrite(size_t count)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Писатель: возвращает количество реально записанных элементов
+    size_t write(const T *src, size_t count)
+    {
+        size_t written = 0;
+        while (written < count)
+        {
+            size_t length;
+            T *dst = writeSpan(length);
+            if (length == 0)
+                break;
+            if (length > count - written)
+                length = count - written;
+            std::memcpy(dst, src + written, length * sizeof(T));
+            commitWrite(length);
+            written += length;
+        }
+        return written;
+    }
+
+    // Читатель: непрерывный заполненный участок, после обработки вызвать commitRead().
+    const T *readSpan(size_t &length) const
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t used = _head.load(std::memory_order_acquire) - tail;
+        const size_t offset = tail & _mask;
+        length = used < _capacity - offset ? used : _capacity - offset;
+        return _data.get() + offset;
+    }
+
+    void commitRead(size_t count)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Читатель: возвращает количество прочитанных элементов
+    size_t read(T *dst, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            size_t length;
+            const T *src = readSpan(length);
+            if (length == 0)
+                break;
+            if (length > count - done)
+                length = count - done;
+            std::memcpy(dst + done, src, length * sizeof(T));
+            commitRead(length);
+            done += length;
+        }
+        return done;
+    }
+
+private:
+    static size_t roundUpPow2(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    const size_t _capacity;
+    const size_t _mask;
+    std::unique_ptr<T[]> _data;
+
+    // Индексы растут монотонно, позиция в буфере - индекс & _mask
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+};
+
+#endif // SPSCRINGBUFFER_H